@@ -0,0 +1,460 @@
+/*
+* Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include "Cpl/Performance.h"
+#include "Cpl/Table.h"
+#include "Cpl/Param.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+#if defined(CPL_PERF_ENABLE)
+namespace Cpl
+{
+    template<class T> CPL_INLINE void DoNotOptimize(const T& value)
+    {
+#if defined(_MSC_VER)
+        static const void* volatile sink;
+        sink = &value;
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "g"(&value) : "memory");
+#endif
+    }
+
+    CPL_INLINE void ClobberMemory()
+    {
+#if defined(_MSC_VER)
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : : "memory");
+#endif
+    }
+
+    CPL_INLINE bool PinThread(int core)
+    {
+        if (core < 0)
+            return false;
+#if defined(_MSC_VER)
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    //-----------------------------------------------------------------------------------------------------
+
+    class BenchmarkState
+    {
+        size_t _iterations;
+        PerformanceMeasurer& _pm;
+
+    public:
+        CPL_INLINE BenchmarkState(size_t iterations, PerformanceMeasurer& pm)
+            : _iterations(iterations)
+            , _pm(pm)
+        {
+        }
+
+        CPL_INLINE size_t Iterations() const
+        {
+            return _iterations;
+        }
+
+        CPL_INLINE void Pause()
+        {
+            _pm.Leave(true);
+        }
+
+        CPL_INLINE void Resume()
+        {
+            _pm.Enter();
+        }
+    };
+
+    typedef void(*BenchmarkPtr)(BenchmarkState& state);
+
+    //-----------------------------------------------------------------------------------------------------
+
+    struct BenchmarkOptions
+    {
+        double minTime, warmupTime;
+        size_t repeats;
+        int core;
+
+        BenchmarkOptions(double mt = 0.05, double wt = 0.02, size_t r = 5, int c = -1)
+            : minTime(mt)
+            , warmupTime(wt)
+            , repeats(r)
+            , core(c)
+        {
+        }
+    };
+
+    //-----------------------------------------------------------------------------------------------------
+
+    typedef std::vector<double> BenchmarkSamples;
+
+    CPL_INLINE double BenchmarkMedian(BenchmarkSamples samples)
+    {
+        if (samples.empty())
+            return 0.0;
+        size_t half = samples.size() / 2;
+        std::nth_element(samples.begin(), samples.begin() + half, samples.end());
+        double median = samples[half];
+        if (samples.size() % 2 == 0)
+            median = (median + *std::max_element(samples.begin(), samples.begin() + half)) / 2.0;
+        return median;
+    }
+
+    CPL_INLINE double BenchmarkMad(const BenchmarkSamples& samples)
+    {
+        double median = BenchmarkMedian(samples);
+        BenchmarkSamples deviations(samples.size());
+        for (size_t i = 0; i < samples.size(); ++i)
+            deviations[i] = std::abs(samples[i] - median);
+        return BenchmarkMedian(deviations);
+    }
+
+    //-----------------------------------------------------------------------------------------------------
+
+    struct BenchmarkResult
+    {
+        String name;
+        size_t iterations;
+        BenchmarkSamples samples;
+        double median, mad, min, max;
+
+        BenchmarkResult(const String& n = String())
+            : name(n)
+            , iterations(0)
+            , median(0)
+            , mad(0)
+            , min(0)
+            , max(0)
+        {
+        }
+    };
+    typedef std::vector<BenchmarkResult> BenchmarkResults;
+
+    CPL_INLINE double BenchmarkRun(BenchmarkPtr benchmark, size_t iterations, PerformanceMeasurer& pm)
+    {
+        PerformanceMeasurer run(pm.Name());
+        BenchmarkState state(iterations, run);
+        run.Enter();
+        benchmark(state);
+        run.Leave();
+        pm.Merge(run);
+        return run.Total();
+    }
+
+    CPL_INLINE BenchmarkResult RunBenchmark(const String& name, BenchmarkPtr benchmark, const BenchmarkOptions& options = BenchmarkOptions())
+    {
+        BenchmarkResult result(name);
+        PerformanceMeasurer warmup(name), pm(name);
+        double target = options.minTime * 1000.0, spent = 0;
+        size_t iterations = 1;
+        for (;;)
+        {
+            double elapsed = BenchmarkRun(benchmark, iterations, warmup);
+            spent += elapsed;
+            if (elapsed >= target && spent >= options.warmupTime * 1000.0)
+                break;
+            if (elapsed < target)
+            {
+                double scale = elapsed > 0 ? 1.2 * target / elapsed : 10.0;
+                iterations = std::max(iterations + 1, size_t(double(iterations) * std::min(scale, 10.0)));
+            }
+        }
+        result.iterations = iterations;
+        for (size_t r = 0; r < std::max<size_t>(options.repeats, 1); ++r)
+            result.samples.push_back(BenchmarkRun(benchmark, iterations, pm) * 1000000.0 / double(iterations));
+        result.median = BenchmarkMedian(result.samples);
+        result.mad = BenchmarkMad(result.samples);
+        result.min = pm.Min() * 1000000.0 / double(iterations);
+        result.max = pm.Max() * 1000000.0 / double(iterations);
+        return result;
+    }
+
+    //-----------------------------------------------------------------------------------------------------
+
+    CPL_INLINE Table BenchmarkTable(const BenchmarkResults& results)
+    {
+        Table table(7, results.size());
+        table.SetHeader(0, "Benchmark", true);
+        table.SetHeader(1, "Iterations", false, Table::Right);
+        table.SetHeader(2, "Repeats", true, Table::Right);
+        table.SetHeader(3, "Median, ns", false, Table::Right);
+        table.SetHeader(4, "MAD, %", true, Table::Right);
+        table.SetHeader(5, "Min, ns", false, Table::Right);
+        table.SetHeader(6, "Max, ns", true, Table::Right);
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchmarkResult& result = results[i];
+            table.SetRowProp(i);
+            table.SetCell(0, i, result.name);
+            table.SetCell(1, i, Cpl::ToStr(result.iterations));
+            table.SetCell(2, i, Cpl::ToStr(result.samples.size()));
+            table.SetCell(3, i, Cpl::ToStr(result.median, 1));
+            table.SetCell(4, i, Cpl::ToStr(result.median > 0 ? result.mad * 100.0 / result.median : 0.0, 1));
+            table.SetCell(5, i, Cpl::ToStr(result.min, 1));
+            table.SetCell(6, i, Cpl::ToStr(result.max, 1));
+        }
+        return table;
+    }
+
+    CPL_INLINE String BenchmarkJson(const BenchmarkResults& results)
+    {
+        std::stringstream json;
+        json << "{" << std::endl << "  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchmarkResult& result = results[i];
+            json << (i ? "," : "") << std::endl << "    {" << std::endl;
+            json << "      \"name\": \"";
+            for (size_t c = 0; c < result.name.size(); ++c)
+            {
+                if (result.name[c] == '"' || result.name[c] == '\\')
+                    json << '\\';
+                json << result.name[c];
+            }
+            json << "\"," << std::endl;
+            json << "      \"iterations\": " << result.iterations << "," << std::endl;
+            json << "      \"median_ns\": " << Cpl::ToStr(result.median, 3) << "," << std::endl;
+            json << "      \"mad_ns\": " << Cpl::ToStr(result.mad, 3) << "," << std::endl;
+            json << "      \"min_ns\": " << Cpl::ToStr(result.min, 3) << "," << std::endl;
+            json << "      \"max_ns\": " << Cpl::ToStr(result.max, 3) << "," << std::endl;
+            json << "      \"samples_ns\": [";
+            for (size_t s = 0; s < result.samples.size(); ++s)
+                json << (s ? ", " : "") << Cpl::ToStr(result.samples[s], 3);
+            json << "]" << std::endl << "    }";
+        }
+        json << std::endl << "  ]" << std::endl << "}" << std::endl;
+        return json.str();
+    }
+
+    //-----------------------------------------------------------------------------------------------------
+
+    struct BenchmarkParam
+    {
+        CPL_PARAM_VALUE(String, name, String());
+        CPL_PARAM_VALUE(size_t, iterations, 0);
+        CPL_PARAM_VALUE(BenchmarkSamples, samples, BenchmarkSamples());
+    };
+
+    struct BenchmarkBaselineParam
+    {
+        CPL_PARAM_VALUE(String, date, String());
+        CPL_PARAM_VECTOR(BenchmarkParam, results);
+    };
+
+    CPL_PARAM_HOLDER(BenchmarkBaseline, BenchmarkBaselineParam, baseline);
+
+    CPL_INLINE bool SaveBenchmarkBaseline(const String& path, const BenchmarkResults& results)
+    {
+        BenchmarkBaseline baseline;
+        baseline().date() = CurrentDateTimeString();
+        baseline().results().resize(results.size());
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            baseline().results()[i].name() = results[i].name;
+            baseline().results()[i].iterations() = results[i].iterations;
+            baseline().results()[i].samples() = results[i].samples;
+        }
+        return baseline.Save(path, true);
+    }
+
+    CPL_INLINE bool LoadBenchmarkBaseline(const String& path, BenchmarkResults& results)
+    {
+        BenchmarkBaseline baseline;
+        if (!baseline.Load(path))
+            return false;
+        results.clear();
+        for (size_t i = 0; i < baseline().results().size(); ++i)
+        {
+            const BenchmarkParam& param = baseline().results()[i];
+            results.push_back(BenchmarkResult(param.name()));
+            BenchmarkResult& result = results.back();
+            result.iterations = param.iterations();
+            result.samples = param.samples();
+            result.median = BenchmarkMedian(result.samples);
+            result.mad = BenchmarkMad(result.samples);
+            if (result.samples.size())
+            {
+                result.min = *std::min_element(result.samples.begin(), result.samples.end());
+                result.max = *std::max_element(result.samples.begin(), result.samples.end());
+            }
+        }
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------------------------
+
+    CPL_INLINE double MannWhitneyPValue(const BenchmarkSamples& a, const BenchmarkSamples& b)
+    {
+        size_t n1 = a.size(), n2 = b.size(), n = n1 + n2;
+        if (n1 == 0 || n2 == 0)
+            return 1.0;
+        std::vector<std::pair<double, size_t>> all;
+        for (size_t i = 0; i < n1; ++i)
+            all.push_back(std::make_pair(a[i], size_t(0)));
+        for (size_t i = 0; i < n2; ++i)
+            all.push_back(std::make_pair(b[i], size_t(1)));
+        std::sort(all.begin(), all.end());
+        double rankSum = 0, ties = 0;
+        for (size_t i = 0; i < n;)
+        {
+            size_t j = i + 1;
+            while (j < n && all[j].first == all[i].first)
+                j++;
+            double rank = double(i + j + 1) / 2.0, t = double(j - i);
+            for (size_t k = i; k < j; ++k)
+                if (all[k].second == 0)
+                    rankSum += rank;
+            ties += t * t * t - t;
+            i = j;
+        }
+        double u = rankSum - double(n1 * (n1 + 1)) / 2.0;
+        double umin = std::min(u, double(n1 * n2) - u);
+        if (ties == 0 && n <= 40)
+        {
+            size_t size = n1 * n2 + 1;
+            std::vector<double> counts((n1 + 1) * (n2 + 1) * size, 0.0);
+            for (size_t i = 0; i <= n1; ++i)
+            {
+                for (size_t j = 0; j <= n2; ++j)
+                {
+                    double* c = counts.data() + (i * (n2 + 1) + j) * size;
+                    if (i == 0 || j == 0)
+                        c[0] = 1.0;
+                    else
+                    {
+                        const double* ci = counts.data() + ((i - 1) * (n2 + 1) + j) * size;
+                        const double* cj = counts.data() + (i * (n2 + 1) + j - 1) * size;
+                        for (size_t k = 0; k <= i * j; ++k)
+                            c[k] = (k >= j ? ci[k - j] : 0.0) + cj[k];
+                    }
+                }
+            }
+            const double* c = counts.data() + (n1 * (n2 + 1) + n2) * size;
+            double total = 0, lower = 0;
+            for (size_t k = 0; k < size; ++k)
+            {
+                total += c[k];
+                if (double(k) <= umin)
+                    lower += c[k];
+            }
+            return std::min(1.0, 2.0 * lower / total);
+        }
+        double mean = double(n1 * n2) / 2.0;
+        double sigma = std::sqrt(double(n1 * n2) / 12.0 * (double(n + 1) - ties / double(n * (n - 1))));
+        if (sigma == 0)
+            return 1.0;
+        double z = (mean - umin - 0.5) / sigma;
+        return std::min(1.0, std::erfc(std::max(z, 0.0) / std::sqrt(2.0)));
+    }
+
+    //-----------------------------------------------------------------------------------------------------
+
+    struct BenchmarkComparison
+    {
+        String name;
+        double baseline, current, change, pValue;
+        bool regression, improvement;
+
+        BenchmarkComparison(const String& n = String())
+            : name(n)
+            , baseline(0)
+            , current(0)
+            , change(0)
+            , pValue(1.0)
+            , regression(false)
+            , improvement(false)
+        {
+        }
+    };
+    typedef std::vector<BenchmarkComparison> BenchmarkComparisons;
+
+    CPL_INLINE BenchmarkComparisons CompareBenchmarks(const BenchmarkResults& baseline, const BenchmarkResults& current, double threshold, double alpha)
+    {
+        BenchmarkComparisons comparisons;
+        for (size_t c = 0; c < current.size(); ++c)
+        {
+            for (size_t b = 0; b < baseline.size(); ++b)
+            {
+                if (baseline[b].name != current[c].name)
+                    continue;
+                BenchmarkComparison comparison(current[c].name);
+                comparison.baseline = baseline[b].median;
+                comparison.current = current[c].median;
+                if (comparison.baseline > 0)
+                    comparison.change = (comparison.current / comparison.baseline - 1.0) * 100.0;
+                comparison.pValue = MannWhitneyPValue(baseline[b].samples, current[c].samples);
+                bool significant = comparison.pValue < alpha;
+                comparison.regression = significant && comparison.change > threshold;
+                comparison.improvement = significant && comparison.change < -threshold;
+                comparisons.push_back(comparison);
+                break;
+            }
+        }
+        return comparisons;
+    }
+
+    CPL_INLINE Table BenchmarkCompareTable(const BenchmarkComparisons& comparisons)
+    {
+        Table table(6, comparisons.size());
+        table.SetHeader(0, "Benchmark", true);
+        table.SetHeader(1, "Baseline, ns", false, Table::Right);
+        table.SetHeader(2, "Current, ns", true, Table::Right);
+        table.SetHeader(3, "Change, %", false, Table::Right);
+        table.SetHeader(4, "p-value", true, Table::Right);
+        table.SetHeader(5, "Status", true, Table::Center);
+        for (size_t i = 0; i < comparisons.size(); ++i)
+        {
+            const BenchmarkComparison& comparison = comparisons[i];
+            Table::Color color = comparison.regression ? Table::Red : Table::Black;
+            table.SetRowProp(i);
+            table.SetCell(0, i, comparison.name, color);
+            table.SetCell(1, i, Cpl::ToStr(comparison.baseline, 1));
+            table.SetCell(2, i, Cpl::ToStr(comparison.current, 1), color);
+            table.SetCell(3, i, (comparison.change > 0 ? "+" : "") + Cpl::ToStr(comparison.change, 1), color);
+            table.SetCell(4, i, Cpl::ToStr(comparison.pValue, 4));
+            table.SetCell(5, i, comparison.regression ? "regression" : (comparison.improvement ? "improvement" : "same"), color);
+        }
+        return table;
+    }
+}
+#endif
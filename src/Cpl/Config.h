@@ -28,5 +28,7 @@
 
 #define CPL_PERF_ENABLE
 
+//#define CPL_PERF_ALLOC_ENABLE
+
 //#define CPL_IMPLEMENT
 
@@ -41,9 +41,11 @@
 
 #if defined(_MSC_VER)
 #define CPL_INLINE __forceinline
+#define CPL_NOINLINE __declspec(noinline)
 #define CPL_FUNCTION __FUNCTION__
 #elif defined(__GNUC__)
 #define CPL_INLINE inline __attribute__ ((always_inline))
+#define CPL_NOINLINE __attribute__ ((noinline))
 #define CPL_FUNCTION __PRETTY_FUNCTION__
 #else
 #error This platform is unsupported!
@@ -0,0 +1,716 @@
+/*
+* Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "Cpl/Defs.h"
+#include "Cpl/OutputBuffer.h"
+
+#include <cstring>
+#include <algorithm>
+#include <exception>
+#include <new>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Cpl
+{
+    namespace Json
+    {
+        const size_t STATIC_POOL_SIZE = 16 * 1024;
+        const size_t DYNAMIC_POOL_SIZE = 64 * 1024;
+        const size_t OUTPUT_BUFFER_SIZE = 64 * 1024;
+        const size_t MAX_NESTING_DEPTH = 512;
+
+        class ParseError : public std::exception
+        {
+        public:
+            ParseError(const char* what, const char* where)
+                : _what(what)
+                , _where(where)
+            {
+            }
+
+            const char* what() const throw() override
+            {
+                return _what;
+            }
+
+            const char* Where() const
+            {
+                return _where;
+            }
+
+        private:
+            const char* _what;
+            const char* _where;
+        };
+
+        //-----------------------------------------------------------------------------------------
+
+        class Document;
+
+        /*
+        * Node of parsed JSON. Names and scalar values point into the parsed text (strings are unescaped in place),
+        * children of arrays and objects are linked in document order.
+        */
+        class Value
+        {
+        public:
+            enum Type
+            {
+                NullType,
+                FalseType,
+                TrueType,
+                NumberType,
+                StringType,
+                ArrayType,
+                ObjectType
+            };
+
+            Value(Type type = NullType)
+                : _type(type)
+                , _name(0)
+                , _nameSize(0)
+                , _data(0)
+                , _size(0)
+                , _count(0)
+                , _first(0)
+                , _last(0)
+                , _next(0)
+            {
+            }
+
+            CPL_INLINE Type GetType() const { return _type; }
+
+            CPL_INLINE bool Scalar() const { return _type < ArrayType; }
+
+            CPL_INLINE const char* Name() const { return _name; }
+
+            CPL_INLINE size_t NameSize() const { return _nameSize; }
+
+            CPL_INLINE const char* Data() const { return _data; }
+
+            CPL_INLINE size_t Size() const { return _size; }
+
+            CPL_INLINE size_t Count() const { return _count; }
+
+            CPL_INLINE Value* First() const { return _first; }
+
+            CPL_INLINE Value* Next() const { return _next; }
+
+            std::string AsString() const
+            {
+                if (_type == FalseType)
+                    return "false";
+                if (_type == TrueType)
+                    return "true";
+                return std::string(_data, _size);
+            }
+
+            Value* Find(const char* name, size_t size = 0) const
+            {
+                if (size == 0)
+                    size = strlen(name);
+                for (Value* child = _first; child; child = child->_next)
+                {
+                    if (child->_nameSize == size && memcmp(child->_name, name, size) == 0)
+                        return child;
+                }
+                return 0;
+            }
+
+        private:
+            Type _type;
+            const char* _name;
+            size_t _nameSize;
+            const char* _data;
+            size_t _size, _count;
+            Value* _first, * _last, * _next;
+
+            CPL_INLINE void Append(Value* child)
+            {
+                if (_last)
+                    _last->_next = child;
+                else
+                    _first = child;
+                _last = child;
+                _count++;
+            }
+
+            friend class Document;
+        };
+
+        //-----------------------------------------------------------------------------------------
+
+        /*
+        * Arena for nodes of a Document: a small static block followed by dynamically allocated blocks,
+        * all nodes are released together by Clear().
+        */
+        class MemoryPool
+        {
+        public:
+            MemoryPool()
+                : _ptr(_static)
+                , _end(_static + STATIC_POOL_SIZE)
+            {
+            }
+
+            ~MemoryPool()
+            {
+                Clear();
+            }
+
+            CPL_INLINE Value* AllocateValue(Value::Type type)
+            {
+                return new(Allocate(sizeof(Value))) Value(type);
+            }
+
+            void Clear()
+            {
+                for (size_t i = 0; i < _blocks.size(); ++i)
+                    delete[] _blocks[i];
+                _blocks.clear();
+                _ptr = _static;
+                _end = _static + STATIC_POOL_SIZE;
+            }
+
+        private:
+            char* _ptr, * _end;
+            std::vector<char*> _blocks;
+            alignas(Value) char _static[STATIC_POOL_SIZE];
+
+            CPL_INLINE void* Allocate(size_t size)
+            {
+                size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+                if (_ptr + size > _end)
+                {
+                    size_t capacity = std::max(size, DYNAMIC_POOL_SIZE);
+                    _blocks.push_back(new char[capacity]);
+                    _ptr = _blocks.back();
+                    _end = _ptr + capacity;
+                }
+                void* memory = _ptr;
+                _ptr += size;
+                return memory;
+            }
+
+            MemoryPool(const MemoryPool&);
+            MemoryPool& operator = (const MemoryPool&);
+        };
+
+        //-----------------------------------------------------------------------------------------
+
+        /*
+        * In-situ JSON parser: the text must stay alive while the document is used, escaped strings are decoded
+        * in place. Throws ParseError on malformed input or on nesting deeper than MAX_NESTING_DEPTH.
+        */
+        class Document : public Value, public MemoryPool
+        {
+        public:
+            Document()
+                : Value(NullType)
+                , _end(0)
+            {
+            }
+
+            void Parse(char* text, size_t size)
+            {
+                Clear();
+                *(Value*)this = Value(NullType);
+                _end = text + size;
+                SkipWhitespace(text);
+                ParseValue(text, this, 0);
+                SkipWhitespace(text);
+                if (text != _end)
+                    throw ParseError("unexpected data after the root value", text);
+            }
+
+        private:
+            char* _end;
+
+            CPL_INLINE void SkipWhitespace(char*& text) const
+            {
+                while (text < _end && (*text == ' ' || *text == '\n' || *text == '\r' || *text == '\t'))
+                    ++text;
+            }
+
+            CPL_INLINE void Expect(char*& text, char ch, const char* what) const
+            {
+                if (text == _end || *text != ch)
+                    throw ParseError(what, text);
+                ++text;
+            }
+
+            void ParseValue(char*& text, Value* value, size_t depth)
+            {
+                if (text == _end)
+                    throw ParseError("expected value", text);
+                switch (*text)
+                {
+                case '{':
+                    if (depth == MAX_NESTING_DEPTH)
+                        throw ParseError("too deep nesting", text);
+                    value->_type = ObjectType;
+                    ParseObject(++text, value, depth + 1);
+                    break;
+                case '[':
+                    if (depth == MAX_NESTING_DEPTH)
+                        throw ParseError("too deep nesting", text);
+                    value->_type = ArrayType;
+                    ParseArray(++text, value, depth + 1);
+                    break;
+                case '"':
+                    value->_type = StringType;
+                    value->_data = ParseString(++text, value->_size);
+                    break;
+                case 't':
+                    value->_type = TrueType;
+                    ParseLiteral(text, "true", 4);
+                    break;
+                case 'f':
+                    value->_type = FalseType;
+                    ParseLiteral(text, "false", 5);
+                    break;
+                case 'n':
+                    value->_type = NullType;
+                    ParseLiteral(text, "null", 4);
+                    break;
+                default:
+                    value->_type = NumberType;
+                    value->_data = text;
+                    ParseNumber(text);
+                    value->_size = text - value->_data;
+                }
+            }
+
+            void ParseObject(char*& text, Value* object, size_t depth)
+            {
+                SkipWhitespace(text);
+                if (text < _end && *text == '}')
+                {
+                    ++text;
+                    return;
+                }
+                while (true)
+                {
+                    Expect(text, '"', "expected \"");
+                    Value* child = AllocateValue(NullType);
+                    child->_name = ParseString(text, child->_nameSize);
+                    SkipWhitespace(text);
+                    Expect(text, ':', "expected :");
+                    SkipWhitespace(text);
+                    ParseValue(text, child, depth);
+                    object->Append(child);
+                    SkipWhitespace(text);
+                    if (text < _end && *text == ',')
+                    {
+                        ++text;
+                        SkipWhitespace(text);
+                        continue;
+                    }
+                    Expect(text, '}', "expected , or }");
+                    return;
+                }
+            }
+
+            void ParseArray(char*& text, Value* array, size_t depth)
+            {
+                SkipWhitespace(text);
+                if (text < _end && *text == ']')
+                {
+                    ++text;
+                    return;
+                }
+                while (true)
+                {
+                    Value* child = AllocateValue(NullType);
+                    ParseValue(text, child, depth);
+                    array->Append(child);
+                    SkipWhitespace(text);
+                    if (text < _end && *text == ',')
+                    {
+                        ++text;
+                        SkipWhitespace(text);
+                        continue;
+                    }
+                    Expect(text, ']', "expected , or ]");
+                    return;
+                }
+            }
+
+            void ParseLiteral(char*& text, const char* literal, size_t size) const
+            {
+                if (size_t(_end - text) < size || memcmp(text, literal, size) != 0)
+                    throw ParseError("invalid literal", text);
+                text += size;
+            }
+
+            void ParseNumber(char*& text) const
+            {
+                const char* start = text;
+                if (text < _end && *text == '-')
+                    ++text;
+                if (text < _end && *text == '0')
+                    ++text;
+                else if (!SkipDigits(text))
+                    throw ParseError("invalid number", start);
+                if (text < _end && *text == '.')
+                {
+                    ++text;
+                    if (!SkipDigits(text))
+                        throw ParseError("invalid number", start);
+                }
+                if (text < _end && (*text == 'e' || *text == 'E'))
+                {
+                    ++text;
+                    if (text < _end && (*text == '+' || *text == '-'))
+                        ++text;
+                    if (!SkipDigits(text))
+                        throw ParseError("invalid number", start);
+                }
+            }
+
+            CPL_INLINE bool SkipDigits(char*& text) const
+            {
+                const char* start = text;
+                while (text < _end && *text >= '0' && *text <= '9')
+                    ++text;
+                return text != start;
+            }
+
+            char* ParseString(char*& text, size_t& size) const
+            {
+                char* begin = text;
+                while (text < _end && *text != '"' && *text != '\\')
+                {
+                    if ((unsigned char)*text < 0x20)
+                        throw ParseError("control character in string", text);
+                    ++text;
+                }
+                char* dst = text;
+                while (text < _end && *text != '"')
+                {
+                    if ((unsigned char)*text < 0x20)
+                        throw ParseError("control character in string", text);
+                    if (*text != '\\')
+                    {
+                        *dst++ = *text++;
+                        continue;
+                    }
+                    if (++text == _end)
+                        break;
+                    switch (*text++)
+                    {
+                    case '"': *dst++ = '"'; break;
+                    case '\\': *dst++ = '\\'; break;
+                    case '/': *dst++ = '/'; break;
+                    case 'b': *dst++ = '\b'; break;
+                    case 'f': *dst++ = '\f'; break;
+                    case 'n': *dst++ = '\n'; break;
+                    case 'r': *dst++ = '\r'; break;
+                    case 't': *dst++ = '\t'; break;
+                    case 'u': InsertCodePoint(dst, ParseCodePoint(text)); break;
+                    default:
+                        throw ParseError("invalid escape sequence", text - 1);
+                    }
+                }
+                if (text == _end)
+                    throw ParseError("unterminated string", begin);
+                size = dst - begin;
+                ++text;
+                return begin;
+            }
+
+            unsigned long ParseHex4(char*& text) const
+            {
+                if (_end - text < 4)
+                    throw ParseError("invalid unicode escape", text);
+                unsigned long code = 0;
+                for (int i = 0; i < 4; ++i, ++text)
+                {
+                    char ch = *text;
+                    code <<= 4;
+                    if (ch >= '0' && ch <= '9')
+                        code |= ch - '0';
+                    else if (ch >= 'a' && ch <= 'f')
+                        code |= ch - 'a' + 10;
+                    else if (ch >= 'A' && ch <= 'F')
+                        code |= ch - 'A' + 10;
+                    else
+                        throw ParseError("invalid unicode escape", text);
+                }
+                return code;
+            }
+
+            unsigned long ParseCodePoint(char*& text) const
+            {
+                unsigned long code = ParseHex4(text);
+                if (code >= 0xD800 && code <= 0xDBFF)
+                {
+                    if (_end - text < 6 || text[0] != '\\' || text[1] != 'u')
+                        throw ParseError("invalid surrogate pair", text);
+                    text += 2;
+                    unsigned long low = ParseHex4(text);
+                    if (low < 0xDC00 || low > 0xDFFF)
+                        throw ParseError("invalid surrogate pair", text);
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                else if (code >= 0xDC00 && code <= 0xDFFF)
+                    throw ParseError("invalid surrogate pair", text - 4);
+                return code;
+            }
+
+            static void InsertCodePoint(char*& dst, unsigned long code)
+            {
+                if (code < 0x80)
+                    *dst++ = char(code);
+                else if (code < 0x800)
+                {
+                    *dst++ = char(0xC0 | (code >> 6));
+                    *dst++ = char(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000)
+                {
+                    *dst++ = char(0xE0 | (code >> 12));
+                    *dst++ = char(0x80 | ((code >> 6) & 0x3F));
+                    *dst++ = char(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    *dst++ = char(0xF0 | (code >> 18));
+                    *dst++ = char(0x80 | ((code >> 12) & 0x3F));
+                    *dst++ = char(0x80 | ((code >> 6) & 0x3F));
+                    *dst++ = char(0x80 | (code & 0x3F));
+                }
+            }
+        };
+
+        //-----------------------------------------------------------------------------------------
+
+        CPL_INLINE bool IsNumber(const char* data, size_t size)
+        {
+            const char* end = data + size;
+            if (data < end && *data == '-')
+                ++data;
+            const char* digits = data;
+            while (data < end && *data >= '0' && *data <= '9')
+                ++data;
+            if (data == digits || (*digits == '0' && data - digits > 1))
+                return false;
+            if (data < end && *data == '.')
+            {
+                digits = ++data;
+                while (data < end && *data >= '0' && *data <= '9')
+                    ++data;
+                if (data == digits)
+                    return false;
+            }
+            if (data < end && (*data == 'e' || *data == 'E'))
+            {
+                if (++data < end && (*data == '+' || *data == '-'))
+                    ++data;
+                digits = data;
+                while (data < end && *data >= '0' && *data <= '9')
+                    ++data;
+                if (data == digits)
+                    return false;
+            }
+            return data == end;
+        }
+
+        /*
+        * Streaming JSON writer with an internal output buffer. Commas and indentation are inserted automatically,
+        * indent == 0 gives compact output.
+        */
+        class Writer
+        {
+        public:
+            Writer(std::ostream& os, size_t indent = 4)
+                : _buffer(FlushToStream<char>, &os, OUTPUT_BUFFER_SIZE)
+                , _indent(indent)
+                , _afterKey(false)
+            {
+            }
+
+            void BeginObject()
+            {
+                Separate();
+                Put('{');
+                _first.push_back(true);
+            }
+
+            void EndObject()
+            {
+                Close('}');
+            }
+
+            void BeginArray()
+            {
+                Separate();
+                Put('[');
+                _first.push_back(true);
+            }
+
+            void EndArray()
+            {
+                Close(']');
+            }
+
+            void Key(const char* name, size_t size = 0)
+            {
+                Separate();
+                Quoted(name, size ? size : strlen(name));
+                Put(':');
+                if (_indent)
+                    Put(' ');
+                _afterKey = true;
+            }
+
+            void Text(const char* data, size_t size)
+            {
+                Separate();
+                Quoted(data, size);
+            }
+
+            CPL_INLINE void Text(const std::string& text)
+            {
+                Text(text.c_str(), text.size());
+            }
+
+            void Number(const char* data, size_t size)
+            {
+                Separate();
+                Write(data, size);
+            }
+
+            void Bool(bool value)
+            {
+                Separate();
+                if (value)
+                    Write("true", 4);
+                else
+                    Write("false", 5);
+            }
+
+            void Null()
+            {
+                Separate();
+                Write("null", 4);
+            }
+
+            void Flush()
+            {
+                _buffer.Flush();
+            }
+
+        private:
+            OutputBuffer<char> _buffer;
+            size_t _indent;
+            bool _afterKey;
+            std::vector<bool> _first;
+
+            CPL_INLINE void Put(char ch)
+            {
+                _buffer.Write(ch);
+            }
+
+            CPL_INLINE void Write(const char* data, size_t size)
+            {
+                _buffer.Write(data, size);
+            }
+
+            void NewLine()
+            {
+                if (_indent == 0)
+                    return;
+                Put('\n');
+                _buffer.Fill(' ', _indent * _first.size());
+            }
+
+            void Separate()
+            {
+                if (_afterKey)
+                {
+                    _afterKey = false;
+                    return;
+                }
+                if (_first.empty())
+                    return;
+                if (!_first.back())
+                    Put(',');
+                _first.back() = false;
+                NewLine();
+            }
+
+            void Close(char ch)
+            {
+                bool empty = _first.back();
+                _first.pop_back();
+                if (!empty)
+                    NewLine();
+                Put(ch);
+                if (_first.empty() && _indent)
+                    Put('\n');
+            }
+
+            void Quoted(const char* data, size_t size)
+            {
+                static const char hex[] = "0123456789abcdef";
+                Put('"');
+                const char* run = data, * end = data + size;
+                for (; data < end; ++data)
+                {
+                    unsigned char ch = *data;
+                    if (ch >= 0x20 && ch != '"' && ch != '\\')
+                        continue;
+                    Write(run, data - run);
+                    run = data + 1;
+                    char escape[6] = { '\\', 0, '0', '0', 0, 0 };
+                    switch (ch)
+                    {
+                    case '"': escape[1] = '"'; break;
+                    case '\\': escape[1] = '\\'; break;
+                    case '\b': escape[1] = 'b'; break;
+                    case '\f': escape[1] = 'f'; break;
+                    case '\n': escape[1] = 'n'; break;
+                    case '\r': escape[1] = 'r'; break;
+                    case '\t': escape[1] = 't'; break;
+                    default:
+                        escape[1] = 'u';
+                        escape[4] = hex[ch >> 4];
+                        escape[5] = hex[ch & 0xF];
+                        Write(escape, 6);
+                        continue;
+                    }
+                    Write(escape, 2);
+                }
+                Write(run, end - run);
+                Put('"');
+            }
+        };
+    }
+}
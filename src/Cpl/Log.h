@@ -99,6 +99,34 @@ namespace Cpl
             return _writerId;
         }
 
+        int AddContextWriter(Level level, CallbackRaw callbackRaw, void* userData, int context)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _writers[++_writerId] = Writer(level, NULL, callbackRaw, NULL, userData, context);
+            _levelMax = std::max(_levelMax, level);
+            return _writerId;
+        }
+
+        bool BindWriterToContext(int id, int context)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Writers::iterator it = _writers.find(id);
+            if (it == _writers.end())
+                return false;
+            it->second.context = context;
+            return true;
+        }
+
+        /*
+        * Log context of current thread (0 by default). A writer bound to a context accepts only
+        * messages written from threads with this context.
+        */
+        static CPL_INLINE int& ThreadContext()
+        {
+            static thread_local int context = 0;
+            return context;
+        }
+
         int AddStdWriter(Level level)
         {
             return AddWriter(level, StdWrite, NULL);
@@ -115,6 +143,7 @@ namespace Cpl
 
         bool RemoveWriter(int id)
         {
+            std::lock_guard<std::mutex> lock(_mutex);
             if (_writers.find(id) != _writers.end())
             {
                 _writers.erase(id);
@@ -126,11 +155,13 @@ namespace Cpl
 
         void SetFlags(Flags flags)
         {
+            std::lock_guard<std::mutex> lock(_mutex);
             _flags = flags;
         }
 
         Flags GetFlags() const
         {
+            std::lock_guard<std::mutex> lock(_mutex);
             return _flags;
         }
 
@@ -144,69 +175,31 @@ namespace Cpl
             if (!Enable(level))
                 return;
 
-            std::stringstream ss;
-
-            if (!_rawOnly)
+            int context = ThreadContext();
+            bool format = false;
+            Flags flags = DefaultFlags;
+            String pretty;
             {
-                bool pref = false;
-                if (_flags & WriteDate)
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_rawOnly && Formatted(level, context))
                 {
-                    ss << CurrentDateTimeString(true, false);
-                    pref = true;
+                    format = true;
+                    flags = _flags;
+                    if ((flags & WriteThreadId) && (flags & PrettyThreadId))
+                        pretty = PrettyThreadName();
                 }
-                if (_flags & WriteTime)
-                {
-                    if (pref)
-                        ss << " ";
-                    ss << CurrentDateTimeString(false, true);
-                    pref = true;
-                }
-                if (_flags & WriteThreadId)
-                {
-                    if (pref)
-                        ss << " ";
-                    std::thread::id id = std::this_thread::get_id();
-                    if (_flags & PrettyThreadId)
-                    {
-                        std::lock_guard<std::mutex> lock(_mutex);
-                        if (_prettyThreadNames.find(id) == _prettyThreadNames.end())
-                            _prettyThreadNames[id] = ToStr((int)_prettyThreadNames.size(), 3);
-                        ss << "[" << _prettyThreadNames[id] << "]";
-                    }
-                    else
-                        ss << "[" << id << "]";
-                    pref = true;
-                }
-                if (_flags & WritePrefix)
-                {
-                    if (pref)
-                        ss << " ";
-                    level = std::min(level, Debug);
-                    static const String prefixes[] = { "None", "Error", "Warning", "Info", "Verbose", "Debug" };
-                    if (_flags & ColorezedPrefix)
-                    {
-                        using namespace Console;
-                        static Foreground colors[] = { ForegroundBlack, ForegroundLightRed, ForegroundYellow, ForegroundGreen, ForegroundWhite, ForegroundLightGray };
-                        ss << Stylized(prefixes[level], FormatDefault, colors[level]);
-                    }
-                    else
-                        ss << prefixes[level];
-                }
-                if (pref)
-                    ss << ": ";
-
-                ss << message;
-                ss << std::endl;
             }
-
+            String formatted;
+            if (format)
+                formatted = Format(level, message, flags, pretty);
             std::lock_guard<std::mutex> lock(_mutex);
             for (Writers::const_iterator it = _writers.begin(); it != _writers.end(); ++it)
             {
                 const Writer& writer = it->second;
-                if (level <= writer.level)
+                if (level <= writer.level && writer.Accept(context))
                 {
                     if (writer.callback)
-                        writer.callback(ss.str().c_str(), writer.userData);
+                        writer.callback(formatted.c_str(), writer.userData);
                     else if (writer.callbackRaw)
                         writer.callbackRaw(level, message.c_str(), writer.userData);
                     else if (writer.callbackRawFunc)
@@ -236,14 +229,23 @@ namespace Cpl
             CallbackRaw callbackRaw;
             CallbackRawFunc callbackRawFunc;
             void* userData;
+            int context;
 
-            Writer(Level l = None, Callback c = NULL, CallbackRaw cr = NULL, CallbackRawFunc crf = NULL, void* ud = NULL)
+            static const int AnyContext = -1;
+
+            Writer(Level l = None, Callback c = NULL, CallbackRaw cr = NULL, CallbackRawFunc crf = NULL, void* ud = NULL, int ctx = AnyContext)
                 : level(l)
                 , callback(c)
                 , callbackRaw(cr)
                 , callbackRawFunc(crf)
                 , userData(ud)
+                , context(ctx)
+            {
+            }
+
+            bool Accept(int ctx) const
             {
+                return context == AnyContext || context == ctx;
             }
         };
         typedef std::map<int, Writer> Writers;
@@ -257,6 +259,71 @@ namespace Cpl
         Flags _flags;
         bool _rawOnly;
 
+        bool Formatted(Level level, int context) const
+        {
+            for (Writers::const_iterator it = _writers.begin(); it != _writers.end(); ++it)
+                if (it->second.callback && level <= it->second.level && it->second.Accept(context))
+                    return true;
+            return false;
+        }
+
+        String PrettyThreadName() const
+        {
+            std::thread::id id = std::this_thread::get_id();
+            if (_prettyThreadNames.find(id) == _prettyThreadNames.end())
+                _prettyThreadNames[id] = ToStr((int)_prettyThreadNames.size(), 3);
+            return _prettyThreadNames[id];
+        }
+
+        static String Format(Level level, const String& message, Flags flags, const String& pretty)
+        {
+            std::stringstream ss;
+            bool pref = false;
+            if (flags & WriteDate)
+            {
+                ss << CurrentDateTimeString(true, false);
+                pref = true;
+            }
+            if (flags & WriteTime)
+            {
+                if (pref)
+                    ss << " ";
+                ss << CurrentDateTimeString(false, true);
+                pref = true;
+            }
+            if (flags & WriteThreadId)
+            {
+                if (pref)
+                    ss << " ";
+                if (flags & PrettyThreadId)
+                    ss << "[" << pretty << "]";
+                else
+                    ss << "[" << std::this_thread::get_id() << "]";
+                pref = true;
+            }
+            if (flags & WritePrefix)
+            {
+                if (pref)
+                    ss << " ";
+                level = std::min(level, Debug);
+                static const String prefixes[] = { "None", "Error", "Warning", "Info", "Verbose", "Debug" };
+                if (flags & ColorezedPrefix)
+                {
+                    using namespace Console;
+                    static Foreground colors[] = { ForegroundBlack, ForegroundLightRed, ForegroundYellow, ForegroundGreen, ForegroundWhite, ForegroundLightGray };
+                    ss << Stylized(prefixes[level], FormatDefault, colors[level]);
+                }
+                else
+                    ss << prefixes[level];
+            }
+            if (pref)
+                ss << ": ";
+
+            ss << message;
+            ss << std::endl;
+            return ss.str();
+        }
+
         static void StdWrite(const char* msg, void*)
         {
             std::cout << msg << std::flush;
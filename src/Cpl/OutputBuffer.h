@@ -0,0 +1,128 @@
+/*
+* Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "Cpl/Defs.h"
+
+#include <cstring>
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Cpl
+{
+    /*
+    * Collects written characters in a fixed block and passes full blocks to a flush callback.
+    * It is shared by Xml::Print, Yaml::Serialize and Json::Writer.
+    */
+    template<class Ch = char> class OutputBuffer
+    {
+    public:
+        typedef void (*FlushPtr)(const Ch* data, size_t size, void* userData);
+
+        OutputBuffer(FlushPtr flush, void* userData, size_t capacity = 64 * 1024)
+            : _flush(flush)
+            , _userData(userData)
+            , _data(std::max<size_t>(capacity, 1))
+            , _size(0)
+            , _total(0)
+        {
+        }
+
+        ~OutputBuffer()
+        {
+            Flush();
+        }
+
+        CPL_INLINE void Write(Ch ch)
+        {
+            if (_size == _data.size())
+                Flush();
+            _data[_size++] = ch;
+        }
+
+        void Write(const Ch* data, size_t size)
+        {
+            if (_size + size > _data.size())
+            {
+                Flush();
+                if (size >= _data.size())
+                {
+                    _flush(data, size, _userData);
+                    _total += size;
+                    return;
+                }
+            }
+            memcpy(_data.data() + _size, data, size * sizeof(Ch));
+            _size += size;
+        }
+
+        void Fill(Ch ch, size_t size)
+        {
+            while (size)
+            {
+                if (_size == _data.size())
+                    Flush();
+                size_t part = std::min(size, _data.size() - _size);
+                std::fill(_data.data() + _size, _data.data() + _size + part, ch);
+                _size += part;
+                size -= part;
+            }
+        }
+
+        void Flush()
+        {
+            if (_size)
+            {
+                _flush(_data.data(), _size, _userData);
+                _total += _size;
+                _size = 0;
+            }
+        }
+
+        size_t Total() const
+        {
+            return _total + _size;
+        }
+
+    private:
+        FlushPtr _flush;
+        void* _userData;
+        std::vector<Ch> _data;
+        size_t _size, _total;
+    };
+
+    template<class Ch> inline void FlushToStream(const Ch* data, size_t size, void* userData)
+    {
+        ((std::basic_ostream<Ch>*)userData)->write(data, size);
+    }
+
+    template<class Ch> inline void FlushToString(const Ch* data, size_t size, void* userData)
+    {
+        ((std::basic_string<Ch>*)userData)->append(data, size);
+    }
+}
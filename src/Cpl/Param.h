@@ -30,35 +30,796 @@
 #include "Cpl/Log.h"
 #include "Cpl/Xml.h"
 #include "Cpl/Yaml.h"
+#include "Cpl/Json.h"
 #include "Cpl/File.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
 namespace Cpl
 {
     enum ParamFormat
     {
         ParamFormatXml,
         ParamFormatYaml,
+        ParamFormatJson,
         ParamFormatByExt,
     };
 
-    CPL_INLINE String ToStr(ParamFormat format)
+    CPL_INLINE String ToStr(ParamFormat format)
+    {
+        static const char* names[] = { "XML", "YAML", "JSON", "Auto detection by file extension" };
+        return format >= ParamFormatXml && format <= ParamFormatByExt ? names[format] : "";
+    }
+
+    CPL_INLINE bool DetectParamFormat(const String& path, ParamFormat& format)
+    {
+        if (format != ParamFormatByExt)
+            return true;
+        String ext = ToLowerCase(ExtensionByPath(path));
+        if (ext == ".xml")
+            format = ParamFormatXml;
+        else if (ext == ".yaml" || ext == ".yml")
+            format = ParamFormatYaml;
+        else if (ext == ".json")
+            format = ParamFormatJson;
+        else
+        {
+            CPL_LOG_SS(Error, "This file extension '" << ext << "' is not recognized! ");
+            return false;
+        }
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    /*
+    * Parallel loading of ParamVector and ParamMap items (disabled by default).
+    * Containers with at least 'minItems' items are converted by 'threads' threads (0 - all hardware threads, 1 - serial loading).
+    * Items are converted by threads of ParamLoadPool. Items of nested containers are always loaded serially.
+    * Result and return value are the same as for serial loading.
+    */
+    struct ParamLoadThreads
+    {
+        static void Set(size_t threads, size_t minItems = 1024)
+        {
+            Threads().store(threads);
+            MinItems().store(std::max<size_t>(minItems, 2));
+        }
+
+        static size_t Get(size_t items)
+        {
+            if (Nested() || items < MinItems().load())
+                return 1;
+            size_t threads = Threads().load();
+            if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+            return std::max<size_t>(1, std::min(threads, items));
+        }
+
+        static CPL_INLINE std::atomic<size_t>& Threads()
+        {
+            static std::atomic<size_t> threads(1);
+            return threads;
+        }
+
+        static CPL_INLINE std::atomic<size_t>& MinItems()
+        {
+            static std::atomic<size_t> minItems(1024);
+            return minItems;
+        }
+
+        static CPL_INLINE bool& Nested()
+        {
+            static thread_local bool nested = false;
+            return nested;
+        }
+    };
+
+    /*
+    * Persistent thread pool of parallel Param loading. Run() calls task(i) for i in [0, count): the last index
+    * is processed by the calling thread, which also executes queued jobs while it waits, so the loading progresses
+    * even if worker threads can't be created. Tasks must not throw.
+    */
+    class ParamLoadPool
+    {
+    public:
+        static ParamLoadPool& Global()
+        {
+            static ParamLoadPool pool;
+            return pool;
+        }
+
+        ParamLoadPool()
+            : _stop(false)
+        {
+        }
+
+        ~ParamLoadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _wake.notify_all();
+            for (size_t i = 0; i < _threads.size(); ++i)
+                _threads[i].join();
+        }
+
+        template<class Task> void Run(size_t count, const Task& task)
+        {
+            if (count == 0)
+                return;
+            size_t remaining = count - 1;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                Grow(count - 1);
+                for (size_t i = 0; i + 1 < count; ++i)
+                {
+                    _jobs.push_back([this, &task, &remaining, i]()
+                    {
+                        task(i);
+                        std::lock_guard<std::mutex> lock(_mutex);
+                        if (--remaining == 0)
+                            _done.notify_all();
+                    });
+                }
+            }
+            _wake.notify_all();
+            task(count - 1);
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (remaining)
+            {
+                if (_jobs.empty())
+                    _done.wait(lock);
+                else
+                    Execute(lock);
+            }
+        }
+
+        size_t Size() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _threads.size();
+        }
+
+    private:
+        typedef std::function<void()> Job;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _wake, _done;
+        std::deque<Job> _jobs;
+        std::vector<std::thread> _threads;
+        bool _stop;
+
+        void Grow(size_t size)
+        {
+            try
+            {
+                if (_threads.size() < size)
+                    _threads.reserve(size);
+                while (_threads.size() < size)
+                    _threads.emplace_back(&ParamLoadPool::Work, this);
+            }
+            catch (...)
+            {
+            }
+        }
+
+        void Execute(std::unique_lock<std::mutex>& lock)
+        {
+            Job job = std::move(_jobs.front());
+            _jobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+
+        void Work()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (true)
+            {
+                _wake.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+                if (_jobs.empty())
+                    return;
+                Execute(lock);
+            }
+        }
+    };
+
+    //---------------------------------------------------------------------------------------------
+
+    /*
+    * Parsed document retained by lazy loading (see Param::LoadLazy).
+    * Deferred ParamStruct and ParamVector nodes refer to it until they are loaded.
+    */
+    struct ParamDocument
+    {
+        std::recursive_mutex mutex;
+
+        virtual ~ParamDocument()
+        {
+        }
+    };
+
+    struct ParamDocumentXml : public ParamDocument
+    {
+        Xml::File<char> file;
+        Xml::XmlDocument<char> doc;
+
+        ParamDocumentXml(const char* data, size_t size)
+            : file(data, size)
+        {
+        }
+
+        bool Parse()
+        {
+            try
+            {
+                doc.Parse<Xml::ParseValuesOnly>(file.Data(), file.Size());
+            }
+            catch (std::exception& e)
+            {
+                CPL_LOG_SS(Error, "Can't parse xml! There is an exception: " << e.what());
+                return false;
+            }
+            return true;
+        }
+    };
+
+    struct ParamDocumentYaml : public ParamDocument
+    {
+        Yaml::Node root;
+
+        bool Parse(const char* data, size_t size)
+        {
+            try
+            {
+                Yaml::Parse(root, data, size);
+            }
+            catch (const Yaml::Exception& e)
+            {
+                CPL_LOG_SS(Error, "Exception " << e.GetType() << ": " << e.what());
+                return false;
+            }
+            return true;
+        }
+    };
+
+    struct ParamDocumentJson : public ParamDocument
+    {
+        Xml::File<char> file;
+        Json::Document doc;
+
+        ParamDocumentJson(const char* data, size_t size)
+            : file(data, size)
+        {
+        }
+
+        bool Parse()
+        {
+            try
+            {
+                doc.Parse(file.Data(), file.Size() - 1);
+            }
+            catch (std::exception& e)
+            {
+                CPL_LOG_SS(Error, "Can't parse json! There is an exception: " << e.what());
+                return false;
+            }
+            return doc.GetType() == Json::Value::ObjectType;
+        }
+    };
+
+    /*
+    * State of a deferred node: the node of retained document which will be loaded on first access.
+    * Nodes are deferred only inside of Scope (it is set by Param::LoadLazy and while a deferred node is loaded).
+    */
+    class ParamLazy
+    {
+    public:
+        struct Context
+        {
+            std::shared_ptr<ParamDocument> document;
+            ParamFormat format;
+        };
+
+        class Scope
+        {
+        public:
+            Scope(const Context& context)
+                : _previous(Current())
+            {
+                Current() = context;
+            }
+
+            Scope(const std::shared_ptr<ParamDocument>& document, ParamFormat format)
+                : _previous(Current())
+            {
+                Current().document = document;
+                Current().format = format;
+            }
+
+            ~Scope()
+            {
+                Current() = _previous;
+            }
+
+        private:
+            Context _previous;
+        };
+
+        static CPL_INLINE Context& Current()
+        {
+            static thread_local Context context = { std::shared_ptr<ParamDocument>(), ParamFormatXml };
+            return context;
+        }
+
+        ParamLazy()
+            : _node(NULL)
+            , _format(ParamFormatXml)
+            , _pending(false)
+            , _failed(false)
+        {
+        }
+
+        ParamLazy(const ParamLazy& other)
+            : _document(std::atomic_load(&other._document))
+            , _node(other._node)
+            , _format(other._format)
+            , _pending(other._pending.load())
+            , _failed(other._failed)
+        {
+        }
+
+        ParamLazy& operator = (const ParamLazy& other)
+        {
+            std::atomic_store(&_document, std::atomic_load(&other._document));
+            _node = other._node;
+            _format = other._format;
+            _failed = other._failed;
+            _pending.store(other._pending.load());
+            return *this;
+        }
+
+        CPL_INLINE bool Pending() const
+        {
+            return _pending.load(std::memory_order_acquire);
+        }
+
+        CPL_INLINE bool Failed() const
+        {
+            return _failed;
+        }
+
+        bool Defer(void* node)
+        {
+            const Context& context = Current();
+            if (!context.document)
+                return false;
+            std::atomic_store(&_document, context.document);
+            _node = node;
+            _format = context.format;
+            _failed = false;
+            _pending.store(true, std::memory_order_release);
+            return true;
+        }
+
+        template<class Loader> void Resolve(Loader loader)
+        {
+            std::shared_ptr<ParamDocument> document = std::atomic_load(&_document);
+            if (!document)
+                return;
+            std::lock_guard<std::recursive_mutex> lock(document->mutex);
+            if (!_pending.load(std::memory_order_acquire))
+                return;
+            {
+                Scope scope(document, _format);
+                _failed = !loader(_format, _node);
+            }
+            _node = NULL;
+            std::atomic_store(&_document, std::shared_ptr<ParamDocument>());
+            _pending.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::shared_ptr<ParamDocument> _document;
+        void* _node;
+        ParamFormat _format;
+        std::atomic<bool> _pending;
+        bool _failed;
+    };
+
+    //---------------------------------------------------------------------------------------------
+
+    template<typename> struct ParamValue;
+    template<typename> struct ParamLimited;
+    template<typename> struct ParamArray;
+    template<typename> struct ParamStruct;
+    template<typename> struct ParamVector;
+    template<typename> struct ParamVectorV2;
+    template<typename> struct ParamProp;
+    template<typename> struct ParamStorage;
+    template<typename, typename> struct ParamMap;
+    template<typename, typename> struct ParamMapV2;
+    template<typename> class ParamSnapshot;
+
+    /*
+    * Names and offsets of the parameters of a record (a struct with CPL_PARAM_* members).
+    * It is built once per record type and lets loaders dispatch document children in a single pass.
+    */
+    class ParamSchema
+    {
+    public:
+        ParamSchema()
+            : _keyed(true)
+        {
+        }
+
+        void Add(const char* name, size_t offset, bool keyed)
+        {
+            Member member = { name, strlen(name), offset };
+            _members.push_back(member);
+            _keyed = _keyed && keyed;
+        }
+
+        CPL_INLINE size_t Size() const
+        {
+            return _members.size();
+        }
+
+        CPL_INLINE bool Keyed() const
+        {
+            return _keyed;
+        }
+
+        CPL_INLINE size_t Offset(size_t index) const
+        {
+            return _members[index].offset;
+        }
+
+        CPL_INLINE size_t Find(const char* name, size_t size, size_t hint) const
+        {
+            for (size_t i = 0, n = _members.size(), index = hint < n ? hint : 0; i < n; ++i)
+            {
+                const Member& member = _members[index];
+                if (member.size == size && memcmp(member.name, name, size) == 0)
+                    return index;
+                if (++index == n)
+                    index = 0;
+            }
+            return _members.size();
+        }
+
+    private:
+        struct Member
+        {
+            const char* name;
+            size_t size;
+            size_t offset;
+        };
+        std::vector<Member> _members;
+        bool _keyed;
+    };
+
+    //---------------------------------------------------------------------------------------------
+
+    /*
+    * Minimal set of changes which turns one parameter tree into another (see Param::Diff and Param::Apply).
+    * Paths are relative to the patched node, segments are names of members, indices of vector items
+    * or keys of map items; '%' and '/' inside a segment are escaped as '%25' and '%2F'.
+    * In YAML format paths and values are double-quoted; '%', '"', '\', CR and LF inside them are escaped as '%25', '%22', '%5C', '%0D' and '%0A'.
+    */
+    class ParamPatch
+    {
+    public:
+        enum Op
+        {
+            OpSet,
+            OpResize,
+            OpInsert,
+            OpErase,
+            OpSize
+        };
+
+        struct Change
+        {
+            Op op;
+            String path;
+            String value;
+        };
+
+        CPL_INLINE void Add(Op op, const String& path, const String& value = String())
+        {
+            Change change = { op, path, value };
+            _changes.push_back(change);
+        }
+
+        CPL_INLINE size_t Size() const
+        {
+            return _changes.size();
+        }
+
+        CPL_INLINE bool Empty() const
+        {
+            return _changes.empty();
+        }
+
+        CPL_INLINE const Change& operator [] (size_t index) const
+        {
+            return _changes[index];
+        }
+
+        CPL_INLINE void Clear()
+        {
+            _changes.clear();
+        }
+
+        static CPL_INLINE const char* OpName(Op op)
+        {
+            static const char* names[] = { "set", "resize", "insert", "erase" };
+            return op >= OpSet && op < OpSize ? names[op] : "";
+        }
+
+        static CPL_INLINE bool HasValue(Op op)
+        {
+            return op == OpSet || op == OpResize;
+        }
+
+        static Op OpByName(const String& name)
+        {
+            for (int op = OpSet; op < OpSize; ++op)
+                if (name == OpName((Op)op))
+                    return (Op)op;
+            return OpSize;
+        }
+
+        static String Append(const String& path, const String& segment)
+        {
+            String result = path + "/";
+            for (size_t i = 0; i < segment.size(); ++i)
+            {
+                if (segment[i] == '%')
+                    result += "%25";
+                else if (segment[i] == '/')
+                    result += "%2F";
+                else
+                    result += segment[i];
+            }
+            return result;
+        }
+
+        static bool Next(const String& path, size_t& pos, String& segment)
+        {
+            if (pos >= path.size() || path[pos] != '/')
+                return false;
+            segment.clear();
+            for (++pos; pos < path.size() && path[pos] != '/'; ++pos)
+            {
+                if (path.compare(pos, 3, "%25") == 0)
+                    segment += '%', pos += 2;
+                else if (path.compare(pos, 3, "%2F") == 0)
+                    segment += '/', pos += 2;
+                else
+                    segment += path[pos];
+            }
+            return true;
+        }
+
+        bool Save(std::ostream& os, ParamFormat format) const
+        {
+            if (format == ParamFormatXml)
+            {
+                Xml::XmlDocument<char> doc;
+                Xml::XmlNode<char>* xmlPatch = doc.AllocateNode(Xml::NodeElement, "patch");
+                for (size_t i = 0; i < _changes.size(); ++i)
+                {
+                    const Change& change = _changes[i];
+                    Xml::XmlNode<char>* xmlChange = doc.AllocateNode(Xml::NodeElement, "change");
+                    xmlChange->AppendNode(doc.AllocateNode(Xml::NodeElement, "op", OpName(change.op)));
+                    xmlChange->AppendNode(doc.AllocateNode(Xml::NodeElement, "path", doc.AllocateString(change.path.c_str())));
+                    if (HasValue(change.op))
+                        xmlChange->AppendNode(doc.AllocateNode(Xml::NodeElement, "value", doc.AllocateString(change.value.c_str())));
+                    xmlPatch->AppendNode(xmlChange);
+                }
+                doc.AppendNode(xmlPatch);
+                Xml::Print(os, doc);
+            }
+            else if (format == ParamFormatYaml)
+            {
+                for (size_t i = 0; i < _changes.size(); ++i)
+                {
+                    const Change& change = _changes[i];
+                    os << "- op: " << OpName(change.op) << "\n";
+                    os << "  path: \"" << EscapeYaml(change.path) << "\"\n";
+                    if (HasValue(change.op))
+                        os << "  value: \"" << EscapeYaml(change.value) << "\"\n";
+                }
+                if (!os)
+                {
+                    CPL_LOG_SS(Error, "Can't write ParamPatch in YAML format!");
+                    return false;
+                }
+            }
+            else if (format == ParamFormatJson)
+            {
+                Json::Writer writer(os);
+                writer.BeginArray();
+                for (size_t i = 0; i < _changes.size(); ++i)
+                {
+                    const Change& change = _changes[i];
+                    writer.BeginObject();
+                    writer.Key("op");
+                    writer.Text(OpName(change.op), strlen(OpName(change.op)));
+                    writer.Key("path");
+                    writer.Text(change.path);
+                    if (HasValue(change.op))
+                    {
+                        writer.Key("value");
+                        writer.Text(change.value);
+                    }
+                    writer.EndObject();
+                }
+                writer.EndArray();
+            }
+            else
+            {
+                CPL_LOG_SS(Error, "Can't save ParamPatch in '" << ToStr(format) << "' format !");
+                return false;
+            }
+            return true;
+        }
+
+        bool Load(const char* data, size_t size, ParamFormat format)
+        {
+            _changes.clear();
+            if (format == ParamFormatXml)
+            {
+                Xml::File<char> file(data, size);
+                Xml::XmlDocument<char> doc;
+                try
+                {
+                    doc.Parse<Xml::ParseValuesOnly>(file.Data(), file.Size());
+                }
+                catch (std::exception& e)
+                {
+                    CPL_LOG_SS(Error, "Can't parse xml! There is an exception: " << e.what());
+                    return false;
+                }
+                Xml::XmlNode<char>* xmlPatch = doc.FirstNode("patch");
+                if (xmlPatch == NULL)
+                    return false;
+                for (Xml::XmlNode<char>* xmlChange = xmlPatch->FirstNode("change"); xmlChange; xmlChange = xmlChange->NextSibling("change"))
+                {
+                    Xml::XmlNode<char>* xmlOp = xmlChange->FirstNode("op");
+                    Xml::XmlNode<char>* xmlPath = xmlChange->FirstNode("path");
+                    Xml::XmlNode<char>* xmlValue = xmlChange->FirstNode("value");
+                    Op op = xmlOp ? OpByName(Xml::ExpandedValue(xmlOp)) : OpSize;
+                    if (op == OpSize || xmlPath == NULL || (HasValue(op) && xmlValue == NULL))
+                        return false;
+                    Add(op, Xml::ExpandedValue(xmlPath), xmlValue ? Xml::ExpandedValue(xmlValue) : String());
+                }
+            }
+            else if (format == ParamFormatYaml)
+            {
+                Yaml::Node root;
+                try
+                {
+                    Yaml::Parse(root, data, size);
+                }
+                catch (const Yaml::Exception& e)
+                {
+                    CPL_LOG_SS(Error, "Exception " << e.GetType() << ": " << e.what());
+                    return false;
+                }
+                if (root.Type() == Yaml::Node::None)
+                    return true;
+                if (root.Type() != Yaml::Node::SequenceType)
+                    return false;
+                for (size_t i = 0; i < root.Size(); ++i)
+                {
+                    Yaml::Node& node = root[i];
+                    Op op = OpByName(node["op"].AsString());
+                    if (op == OpSize || node["path"].Type() != Yaml::Node::ScalarType || (HasValue(op) && node["value"].Type() != Yaml::Node::ScalarType))
+                        return false;
+                    Add(op, UnescapeYaml(node["path"].AsString()), node["value"].Type() == Yaml::Node::ScalarType ? UnescapeYaml(node["value"].AsString()) : String());
+                }
+            }
+            else if (format == ParamFormatJson)
+            {
+                Xml::File<char> file(data, size);
+                Json::Document doc;
+                try
+                {
+                    doc.Parse(file.Data(), size);
+                }
+                catch (std::exception& e)
+                {
+                    CPL_LOG_SS(Error, "Can't parse json! There is an exception: " << e.what());
+                    return false;
+                }
+                if (doc.GetType() != Json::Value::ArrayType)
+                    return false;
+                for (Json::Value* item = doc.First(); item; item = item->Next())
+                {
+                    Json::Value* op = item->Find("op"), * path = item->Find("path"), * value = item->Find("value");
+                    if (op == NULL || OpByName(op->AsString()) == OpSize || path == NULL || path->GetType() != Json::Value::StringType ||
+                        (HasValue(OpByName(op->AsString())) && (value == NULL || !value->Scalar())))
+                        return false;
+                    Add(OpByName(op->AsString()), path->AsString(), value ? value->AsString() : String());
+                }
+            }
+            else
+            {
+                CPL_LOG_SS(Error, "Can't load ParamPatch in '" << ToStr(format) << "' format !");
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        std::vector<Change> _changes;
+
+        static String EscapeYaml(const String& text)
+        {
+            String result;
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                switch (text[i])
+                {
+                case '%': result += "%25"; break;
+                case '"': result += "%22"; break;
+                case '\\': result += "%5C"; break;
+                case '\r': result += "%0D"; break;
+                case '\n': result += "%0A"; break;
+                default: result += text[i];
+                }
+            }
+            return result;
+        }
+
+        static String UnescapeYaml(const String& text)
+        {
+            static const char* codes[][2] = { { "%25", "%" }, { "%22", "\"" }, { "%5C", "\\" }, { "%0D", "\r" }, { "%0A", "\n" } };
+            String result;
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                size_t c = 0;
+                while (c < 5 && text.compare(i, 3, codes[c][0]) != 0)
+                    ++c;
+                if (c < 5)
+                    result += codes[c][1], i += 2;
+                else
+                    result += text[i];
+            }
+            return result;
+        }
+    };
+
+    /*
+    * Undo record of one applied change: restores the previous state of the node at given path.
+    * Nodes are found by path at rollback, because later changes can move them (e.g. by resize of a vector).
+    */
+    struct ParamUndo
     {
-        static const char* names[] = { "XML", "YAML", "Auto detection by file extension" };
-        return format >= ParamFormatXml && format <= ParamFormatByExt ? names[format] : "";
-    }
+        String path;
+        std::function<void(void*)> restore;
+    };
+    typedef std::vector<ParamUndo> ParamUndos;
 
     //---------------------------------------------------------------------------------------------
 
-    template<typename> struct ParamValue;
-    template<typename> struct ParamLimited;
-    template<typename> struct ParamStruct;
-    template<typename> struct ParamVector;
-    template<typename> struct ParamVectorV2;
-    template<typename> struct ParamProp;
-    template<typename> struct ParamStorage;
-    template<typename, typename> struct ParamMap;
-    template<typename, typename> struct ParamMapV2;
-
     template<class T> struct Param
     {
         typedef T Type;
@@ -66,7 +827,7 @@ namespace Cpl
         CPL_INLINE const Type& operator () () const { return _value; }
         CPL_INLINE Type& operator () () { return _value; }
 
-        CPL_INLINE const String& Name() const { return _name; };
+        CPL_INLINE const char* Name() const { return _name; };
 
         virtual bool Changed() const = 0;
 
@@ -80,6 +841,33 @@ namespace Cpl
             CloneNode((Unknown*)&other);
         }
 
+        CPL_INLINE ParamPatch Diff(const Param& other) const
+        {
+            ParamPatch patch;
+            DiffNode((Unknown*)&other, String(), patch);
+            return patch;
+        }
+
+        bool Apply(const ParamPatch& patch)
+        {
+            ParamUndos undos;
+            for (size_t i = 0; i < patch.Size(); ++i)
+            {
+                if (!ApplyNode(patch[i], 0, undos))
+                {
+                    CPL_LOG_SS(Error, "Can't apply '" << ParamPatch::OpName(patch[i].op) << "' to '" << patch[i].path << "' !");
+                    for (size_t u = undos.size(); u-- > 0;)
+                    {
+                        Unknown* node = FindNode(undos[u].path, 0);
+                        assert(node);
+                        undos[u].restore(node);
+                    }
+                    return false;
+                }
+            }
+            return true;
+        }
+
         bool Save(std::ostream& os, bool full, ParamFormat format) const
         {
             if (format == ParamFormatXml)
@@ -100,12 +888,19 @@ namespace Cpl
                 {
                     Yaml::Serialize(root, os);
                 }
-                catch (const Yaml::Exception e)
+                catch (const Yaml::Exception& e)
                 {
                     CPL_LOG_SS(Error, "Exception " << e.GetType() << ": " << e.what());
                     return false;
                 }
             }
+            else if (format == ParamFormatJson)
+            {
+                Json::Writer writer(os);
+                writer.BeginObject();
+                this->SaveNodeJson(writer, full);
+                writer.EndObject();
+            }
             else
             {
                 CPL_LOG_SS(Error, "Can't save Param in '" << ToStr(format) << "' format !");
@@ -146,13 +941,18 @@ namespace Cpl
                 {
                     Yaml::Parse(root, data, size);
                 }
-                catch (const Yaml::Exception e)
+                catch (const Yaml::Exception& e)
                 {
                     CPL_LOG_SS(Error, "Exception " << e.GetType() << ": " << e.what());
                     return false;
                 }
                 return LoadNodeYaml(root);
             }
+            else if (format == ParamFormatJson)
+            {
+                Xml::File<char> file(data, size);
+                return LoadJson(file);
+            }
             else
             {
                 CPL_LOG_SS(Error, "Can't load Param in '" << ToStr(format) << "' format !");
@@ -174,13 +974,18 @@ namespace Cpl
                 {
                     Yaml::Parse(root, is);
                 }
-                catch (const Yaml::Exception e)
+                catch (const Yaml::Exception& e)
                 {
                     CPL_LOG_SS(Error, "Exception " << e.GetType() << ": " << e.what());
                     return false;
                 }
                 return LoadNodeYaml(root);
             }
+            else if (format == ParamFormatJson)
+            {
+                Xml::File<char> file(is);
+                return LoadJson(file);
+            }
             else
             {
                 CPL_LOG_SS(Error, "Can't load Param in '" << ToStr(format) << "' format !");
@@ -199,74 +1004,423 @@ namespace Cpl
                 result = this->Load(ifs, format);
                 ifs.close();
             }
-            else
+            else
+            {
+                CPL_LOG_SS(Error, "Can't open input file: '" << path << "' !");
+            }
+            return result;
+        }
+
+        /*
+        * Loads parameters, but nodes declared by CPL_PARAM_STRUCT_LAZY and CPL_PARAM_VECTOR_LAZY keep a reference
+        * to the retained parsed document and are loaded on first access (or by Materialize()). Other nodes are loaded at once.
+        */
+        bool LoadLazy(const char* data, size_t size, ParamFormat format)
+        {
+            bool result = false;
+            if (format == ParamFormatXml)
+            {
+                std::shared_ptr<ParamDocumentXml> document = std::make_shared<ParamDocumentXml>(data, size);
+                if (!document->Parse())
+                    return false;
+                ParamLazy::Scope scope(document, format);
+                result = this->LoadNodeXml(&document->doc);
+            }
+            else if (format == ParamFormatYaml)
+            {
+                std::shared_ptr<ParamDocumentYaml> document = std::make_shared<ParamDocumentYaml>();
+                if (!document->Parse(data, size))
+                    return false;
+                ParamLazy::Scope scope(document, format);
+                result = this->LoadNodeYaml(document->root);
+            }
+            else if (format == ParamFormatJson)
+            {
+                std::shared_ptr<ParamDocumentJson> document = std::make_shared<ParamDocumentJson>(data, size);
+                if (!document->Parse())
+                    return false;
+                ParamLazy::Scope scope(document, format);
+                result = this->LoadNodeJson(document->doc);
+            }
+            else
+            {
+                CPL_LOG_SS(Error, "Can't load Param in '" << ToStr(format) << "' format !");
+                return false;
+            }
+            return this->MaterializeNode(false) && result;
+        }
+
+        bool LoadLazy(const String& path, ParamFormat format = ParamFormatByExt)
+        {
+            if (!DetectFormat(path, format))
+                return false;
+            std::ifstream ifs(path.c_str());
+            if (!ifs.is_open())
+            {
+                CPL_LOG_SS(Error, "Can't open input file: '" << path << "' !");
+                return false;
+            }
+            std::stringstream ss;
+            ss << ifs.rdbuf();
+            String data = ss.str();
+            return this->LoadLazy(data.c_str(), data.size(), format);
+        }
+
+        /*
+        * Loads all deferred nodes of lazy loading. Returns false if any of them is failed.
+        */
+        CPL_INLINE bool Materialize()
+        {
+            return this->MaterializeNode(true);
+        }
+
+    protected:
+        const char* _name;
+        Type _value;
+
+        Param(const char* name)
+            : _name(name)
+            , _value()
+        {
+        }
+
+        bool DetectFormat(const String & path, ParamFormat &format) const
+        {
+            return DetectParamFormat(path, format);
+        }
+
+        bool LoadXml(Xml::File<char>& file)
+        {
+            Xml::XmlDocument<char> doc;
+            try
+            {
+                doc.Parse<Xml::ParseValuesOnly>(file.Data(), file.Size());
+            }
+            catch (std::exception& e)
+            {
+                CPL_LOG_SS(Error, "Can't parse xml! There is an exception: " << e.what());
+                return false;
+            }
+            return this->LoadNodeXml(&doc);
+        }
+
+        bool LoadJson(Xml::File<char>& file)
+        {
+            Json::Document doc;
+            try
+            {
+                doc.Parse(file.Data(), file.Size() - 1);
+            }
+            catch (std::exception& e)
+            {
+                CPL_LOG_SS(Error, "Can't parse json! There is an exception: " << e.what());
+                return false;
+            }
+            if (doc.GetType() != Json::Value::ObjectType)
+                return false;
+            return this->LoadNodeJson(doc);
+        }
+
+        typedef Param<int> Unknown;
+
+        virtual Unknown* End() const = 0;
+
+        virtual bool EqualNode(const Unknown* other) const = 0;
+
+        virtual void CloneNode(const Unknown* other) = 0;
+
+        virtual void DiffNode(const Unknown* other, const String& path, ParamPatch& patch) const = 0;
+
+        virtual bool ApplyNode(const ParamPatch::Change& change, size_t pos, ParamUndos& undos) = 0;
+
+        virtual Unknown* FindNode(const String& path, size_t pos)
+        {
+            return pos == path.size() ? (Unknown*)this : NULL;
+        }
+
+        virtual bool MaterializeNode(bool)
+        {
+            return true;
+        }
+
+        static bool MaterializeRecord(Unknown* beg, Unknown* end)
+        {
+            bool result = true;
+            for (; beg < end; beg = beg->End())
+                result = beg->MaterializeNode(true) && result;
+            return result;
+        }
+
+        static void DiffRecord(const Unknown* beg, const Unknown* end, const Unknown* other, const String& path, ParamPatch& patch)
+        {
+            for (; beg < end; beg = beg->End(), other = other->End())
+                beg->DiffNode(other, ParamPatch::Append(path, beg->Name()), patch);
+        }
+
+        static bool ApplyRecord(Unknown* beg, Unknown* end, const ParamPatch::Change& change, size_t pos, ParamUndos& undos)
+        {
+            String name;
+            if (!ParamPatch::Next(change.path, pos, name))
+                return false;
+            for (; beg < end; beg = beg->End())
+            {
+                if (name == beg->Name())
+                    return beg->ApplyNode(change, pos, undos);
+            }
+            return false;
+        }
+
+        static Unknown* FindRecord(Unknown* beg, Unknown* end, const String& path, size_t pos)
+        {
+            String name;
+            if (!ParamPatch::Next(path, pos, name))
+                return NULL;
+            for (; beg < end; beg = beg->End())
+            {
+                if (name == beg->Name())
+                    return beg->FindNode(path, pos);
+            }
+            return NULL;
+        }
+
+        virtual bool LoadNodeXml(Xml::XmlNode<char>* xmlParent)
+        {
+            Xml::XmlNode<char>* xmlCurrent = xmlParent->FirstNode(this->Name());
+            return xmlCurrent ? this->LoadCurrentXml(xmlCurrent) : true;
+        }
+
+        virtual bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) = 0;
+
+        virtual void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const = 0;
+
+        virtual bool LoadNodeYaml(Yaml::Node& node)
+        {
+            Yaml::Node& current = node[this->Name()];
+            return current.Type() == Yaml::Node::None ? true : this->LoadCurrentYaml(current);
+        }
+
+        virtual bool LoadCurrentYaml(Yaml::Node& current) = 0;
+
+        virtual bool KeyedByName() const
+        {
+            return true;
+        }
+
+        template<class R> static const ParamSchema& RecordSchema(const Unknown* beg, const Unknown* end)
+        {
+            static const ParamSchema schema = BuildSchema(beg, end);
+            return schema;
+        }
+
+        static ParamSchema BuildSchema(const Unknown* beg, const Unknown* end)
+        {
+            ParamSchema schema;
+            for (const Unknown* child = beg; child < end; child = child->End())
+                schema.Add(child->Name(), (const char*)child - (const char*)beg, child->KeyedByName());
+            return schema;
+        }
+
+        template<class R> static bool LoadRecordXml(Unknown* beg, Unknown* end, Xml::XmlNode<char>* xmlCurrent)
+        {
+            const ParamSchema& schema = RecordSchema<R>(beg, end);
+            if (!schema.Keyed())
+            {
+                for (Unknown* paramChild = beg; paramChild < end; paramChild = paramChild->End())
+                {
+                    if (!paramChild->LoadNodeXml(xmlCurrent))
+                        return false;
+                }
+                return true;
+            }
+            uint64_t loaded = 0;
+            std::vector<bool> loadedMore(schema.Size() > 64 ? schema.Size() - 64 : 0);
+            size_t hint = 0;
+            for (Xml::XmlNode<char>* xmlChild = xmlCurrent->FirstNode(); xmlChild; xmlChild = xmlChild->NextSibling())
+            {
+                if (xmlChild->Type() != Xml::NodeElement)
+                    continue;
+                size_t index = schema.Find(xmlChild->Name(), xmlChild->NameSize(), hint);
+                if (index == schema.Size())
+                    continue;
+                if (index < 64 ? (loaded & (uint64_t(1) << index)) != 0 : loadedMore[index - 64])
+                    continue;
+                if (index < 64)
+                    loaded |= uint64_t(1) << index;
+                else
+                    loadedMore[index - 64] = true;
+                hint = index + 1;
+                Unknown* paramChild = (Unknown*)((char*)beg + schema.Offset(index));
+                if (!paramChild->LoadCurrentXml(xmlChild))
+                    return false;
+            }
+            return true;
+        }
+
+        template<class R> static bool LoadRecordYaml(Unknown* beg, Unknown* end, Yaml::Node& current)
+        {
+            const ParamSchema& schema = RecordSchema<R>(beg, end);
+            if (!schema.Keyed() || current.Type() != Yaml::Node::MapType)
+            {
+                for (Unknown* paramChild = beg; paramChild < end; paramChild = paramChild->End())
+                {
+                    if (!paramChild->LoadNodeYaml(current))
+                        return false;
+                }
+                return true;
+            }
+            size_t hint = 0;
+            for (Yaml::Iterator it = current.Begin(), stop = current.End(); it != stop; it++)
+            {
+                const String& key = (*it).first;
+                size_t index = schema.Find(key.c_str(), key.size(), hint);
+                if (index == schema.Size())
+                    continue;
+                hint = index + 1;
+                Yaml::Node& child = (*it).second;
+                Unknown* paramChild = (Unknown*)((char*)beg + schema.Offset(index));
+                if (child.Type() != Yaml::Node::None && !paramChild->LoadCurrentYaml(child))
+                    return false;
+            }
+            return true;
+        }
+
+        virtual void SaveNodeYaml(Yaml::Node & node, bool full) const = 0;
+
+        virtual bool LoadNodeJson(Json::Value& parent)
+        {
+            Json::Value* current = parent.Find(this->Name());
+            return current && current->GetType() != Json::Value::NullType ? this->LoadCurrentJson(*current) : true;
+        }
+
+        virtual bool LoadCurrentJson(Json::Value& current) = 0;
+
+        virtual void SaveNodeJson(Json::Writer& writer, bool full) const = 0;
+
+        template<class R> static bool LoadRecordJson(Unknown* beg, Unknown* end, Json::Value& current)
+        {
+            const ParamSchema& schema = RecordSchema<R>(beg, end);
+            if (!schema.Keyed())
+            {
+                for (Unknown* paramChild = beg; paramChild < end; paramChild = paramChild->End())
+                {
+                    if (!paramChild->LoadNodeJson(current))
+                        return false;
+                }
+                return true;
+            }
+            size_t hint = 0;
+            for (Json::Value* child = current.First(); child; child = child->Next())
             {
-                CPL_LOG_SS(Error, "Can't open input file: '" << path << "' !");
+                size_t index = schema.Find(child->Name(), child->NameSize(), hint);
+                if (index == schema.Size())
+                    continue;
+                hint = index + 1;
+                Unknown* paramChild = (Unknown*)((char*)beg + schema.Offset(index));
+                if (child->GetType() != Json::Value::NullType && !paramChild->LoadCurrentJson(*child))
+                    return false;
             }
-            return result;
+            return true;
         }
 
-    protected:
-        String _name;
-        Type _value;
+        template<class R> static CPL_INLINE bool LoadRecord(R& record, Xml::XmlNode<char>* node)
+        {
+            return LoadRecordXml<R>((Unknown*)&record, (Unknown*)(&record + 1), node);
+        }
 
-        Param(const String &name)
-            : _name(name)
-            , _value()
+        template<class R> static CPL_INLINE bool LoadRecord(R& record, Yaml::Node* node)
         {
+            return LoadRecordYaml<R>((Unknown*)&record, (Unknown*)(&record + 1), *node);
         }
 
-        bool DetectFormat(const String & path, ParamFormat &format) const
+        template<class R> static CPL_INLINE bool LoadRecord(R& record, Json::Value* node)
         {
-            if (format != ParamFormatByExt)
-                return true;
-            String ext = ToLowerCase(ExtensionByPath(path));
-            if (ext == ".xml")
-                format = ParamFormatXml;
-            else if (ext == ".yaml" || ext == ".yml")
-                format = ParamFormatYaml;
-            else
-            {
-                CPL_LOG_SS(Error, "This file extension '" << ext << "' is not recognized! ");
-                return false;
-            }
-            return true;
+            return LoadRecordJson<R>((Unknown*)&record, (Unknown*)(&record + 1), *node);
         }
 
-        bool LoadXml(Xml::File<char>& file)
+        /*
+        * Loads records from nodes (NULL nodes are skipped) and returns index of the first failed record (or size).
+        * In parallel mode records after the failed one are restored as serial loading would leave them:
+        * the first 'keep' records to their previous values, others to R().
+        */
+        template<class R, class N> static size_t LoadRecords(R* const* records, N* const* nodes, size_t size, size_t threads, size_t keep)
         {
-            Xml::XmlDocument<char> doc;
-            try
+            if (threads < 2)
             {
-                doc.Parse<0>(file.Data(), file.Size());
+                for (size_t i = 0; i < size; ++i)
+                {
+                    if (nodes[i] && !LoadRecord(*records[i], nodes[i]))
+                        return i;
+                }
+                return size;
             }
-            catch (std::exception& e)
+            std::vector<size_t> stops(threads, size), ends(threads, 0);
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::vector<R>> backups(threads);
+            std::atomic<size_t> first(size);
+            ParamLazy::Context context = ParamLazy::Current();
+            auto task = [&](size_t t)
             {
-                CPL_LOG_SS(Error, "Can't parse xml! There is an exception: " << e.what());
-                return false;
+                ParamLazy::Scope scope(context);
+                bool& nested = ParamLoadThreads::Nested();
+                bool outer = nested;
+                nested = true;
+                size_t i = size * t / threads, end = size * (t + 1) / threads;
+                for (; i < end && i < first.load(std::memory_order_relaxed); ++i)
+                {
+                    try
+                    {
+                        if (t && i < keep)
+                            backups[t].push_back(*records[i]);
+                        if (nodes[i] && !LoadRecord(*records[i], nodes[i]))
+                        {
+                            stops[t] = i;
+                            break;
+                        }
+                    }
+                    catch (...)
+                    {
+                        errors[t] = std::current_exception();
+                        stops[t] = i;
+                        break;
+                    }
+                }
+                ends[t] = i;
+                for (size_t stop = first.load(); stops[t] < stop && !first.compare_exchange_weak(stop, stops[t]);)
+                    ;
+                nested = outer;
+            };
+            ParamLoadPool::Global().Run(threads, task);
+            size_t stop = first.load();
+            if (stop == size)
+                return size;
+            for (size_t t = 1; t < threads; ++t)
+            {
+                for (size_t i = std::max(size * t / threads, stop + 1); i < ends[t]; ++i)
+                    *records[i] = i < keep ? backups[t][i - size * t / threads] : R();
             }
-            return this->LoadNodeXml(&doc);
+            for (size_t t = 0; t < threads; ++t)
+            {
+                if (stops[t] == stop && errors[t])
+                    std::rethrow_exception(errors[t]);
+            }
+            return stop;
         }
 
-        typedef Param<int> Unknown;
-
-        virtual Unknown* End() const = 0;
-
-        virtual bool EqualNode(const Unknown* other) const = 0;
-
-        virtual void CloneNode(const Unknown* other) = 0;
-
-        virtual bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) = 0;
-
-        virtual void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const = 0;
-
-        virtual bool LoadNodeYaml(Yaml::Node& node) = 0;
-
-        virtual void SaveNodeYaml(Yaml::Node & node, bool full) const = 0;
+        static void SaveRecordJson(const Unknown* beg, const Unknown* end, Json::Writer& writer, bool full)
+        {
+            writer.BeginObject();
+            for (const Unknown* paramChild = beg; paramChild < end; paramChild = paramChild->End())
+            {
+                if (full || paramChild->Changed())
+                    paramChild->SaveNodeJson(writer, full);
+            }
+            writer.EndObject();
+        }
 
         template<typename> friend struct Param;
         template<typename> friend struct ParamValue;
         template<typename> friend struct ParamLimited;
+        template<typename> friend struct ParamArray;
         template<typename> friend struct ParamStruct;
         template<typename> friend struct ParamVector;
         template<typename> friend struct ParamVectorV2;
@@ -274,6 +1428,7 @@ namespace Cpl
         template<typename> friend struct ParamStorage;
         template<typename, typename> friend struct ParamMap;
         template<typename, typename> friend struct ParamMapV2;
+        template<typename> friend class ParamSnapshot;
     };
 
     //---------------------------------------------------------------------------------------------
@@ -296,7 +1451,7 @@ namespace Cpl
         typedef Cpl::Param<T> Base;
         typedef Cpl::Param<int> Unknown;
 
-        ParamValue(const String& name)
+        ParamValue(const char* name)
             : Base(name)
         {
         } 
@@ -316,32 +1471,45 @@ namespace Cpl
             this->_value = ((ParamValue*)other)->_value;
         }
 
-        bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
+        void DiffNode(const Unknown* other, const String& path, ParamPatch& patch) const override
+        {
+            if (!(this->_value == ((ParamValue*)other)->_value))
+                patch.Add(ParamPatch::OpSet, path, Cpl::ToStr(((ParamValue*)other)->_value));
+        }
+
+        bool ApplyNode(const ParamPatch::Change& change, size_t pos, ParamUndos& undos) override
+        {
+            if (pos != change.path.size() || change.op != ParamPatch::OpSet)
+                return false;
+            Type value;
+            if (!Cpl::TryToVal(change.value, value))
+                return false;
+            Type previous = this->_value;
+            undos.push_back(ParamUndo{ change.path, [previous](void* node) { ((ParamValue*)node)->_value = previous; } });
+            this->_value = value;
+            return true;
+        }
+
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlParent->FirstNode(this->Name().c_str());
-            if (xmlCurrent)
-                Cpl::ToVal(xmlCurrent->Value(), this->_value);
+            Cpl::ToVal(Xml::ExpandedValue(xmlCurrent), this->_value);
             return true;
         }
 
         void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(this->Name().c_str()));
+            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, this->Name());
             xmlCurrent->Value(xmlDoc.AllocateString(Cpl::ToStr(this->_value).c_str()));
             xmlParent->AppendNode(xmlCurrent);
         }
 
-        bool LoadNodeYaml(Yaml::Node& node) override
+        bool LoadCurrentYaml(Yaml::Node& current) override
         {
-            Yaml::Node & current = node[this->Name()];
-            if (current.Type() != Yaml::Node::None)
-            {
-                if (current.Type() != Yaml::Node::ScalarType)
-                    return false;
-                String string = current.As<String>();
-                if(string != "\n")
-                    Cpl::ToVal(current.As<String>(), this->_value);
-            }
+            if (current.Type() != Yaml::Node::ScalarType)
+                return false;
+            const String & string = current.AsString();
+            if(string != "\n")
+                Cpl::ToVal(string, this->_value);
             return true;
         }
 
@@ -349,6 +1517,27 @@ namespace Cpl
         {
             node[this->Name()] = Cpl::ToStr(this->_value);
         }
+
+        bool LoadCurrentJson(Json::Value& current) override
+        {
+            if (!current.Scalar())
+                return false;
+            if (current.GetType() != Json::Value::NullType)
+                Cpl::ToVal(current.AsString(), this->_value);
+            return true;
+        }
+
+        void SaveNodeJson(Json::Writer& writer, bool) const override
+        {
+            String string = Cpl::ToStr(this->_value);
+            writer.Key(this->Name());
+            if (std::is_same<Type, bool>::value)
+                writer.Bool(string == "1");
+            else if (std::is_arithmetic<Type>::value && Json::IsNumber(string.c_str(), string.size()))
+                writer.Number(string.c_str(), string.size());
+            else
+                writer.Text(string);
+        }
     };
 
     //---------------------------------------------------------------------------------------------
@@ -416,36 +1605,320 @@ namespace Cpl
         typedef Cpl::ParamValue<T> Base;
         typedef Cpl::Param<int> Unknown;
 
-        ParamLimited(const String& name)
+        ParamLimited(const char* name)
             : Base(name)
         {
         }
 
-        bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
+        {
+            T value;
+            Cpl::ToVal(Xml::ExpandedValue(xmlCurrent), value);
+            (*this)() = value;
+            return true;
+        }
+
+        bool LoadCurrentYaml(Yaml::Node& current) override
+        {
+            if (current.Type() != Yaml::Node::ScalarType)
+                return false;
+            T value;
+            Cpl::ToVal(current.AsString(), value);
+            (*this)() = value;
+            return true;
+        }
+
+        bool LoadCurrentJson(Json::Value& current) override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlParent->FirstNode(this->Name().c_str());
-            if (xmlCurrent)
+            if (!current.Scalar())
+                return false;
+            if (current.GetType() != Json::Value::NullType)
             {
                 T value;
-                Cpl::ToVal(xmlCurrent->Value(), value);
+                Cpl::ToVal(current.AsString(), value);
                 (*this)() = value;
             }
             return true;
         }
 
-        bool LoadNodeYaml(Yaml::Node& node) override
+        bool ApplyNode(const ParamPatch::Change& change, size_t pos, ParamUndos& undos) override
         {
-            Yaml::Node& current = node[this->Name()];
-            if (current.Type() != Yaml::Node::None)
+            if (pos != change.path.size() || change.op != ParamPatch::OpSet)
+                return false;
+            T value;
+            if (!Cpl::TryToVal(change.value, value))
+                return false;
+            T previous = this->_value;
+            undos.push_back(ParamUndo{ change.path, [previous](void* node) { ((ParamLimited*)node)->_value = previous; } });
+            (*this)() = value;
+            return true;
+        }
+    };
+
+    //---------------------------------------------------------------------------------------------
+
+    enum ParamArrayEncoding
+    {
+        ParamArrayText,
+        ParamArrayBase64,
+    };
+
+    /*
+    * Contiguous array of numbers (T is an arithmetic type). It is saved as a list of numbers separated by spaces
+    * (a JSON array in JSON format) or as raw bytes of the array in base64 with "base64:" prefix.
+    * Both forms are accepted at loading independently of Encoding().
+    */
+    template<class T> struct ParamArray : public Cpl::Param<std::vector<T>>
+    {
+        typedef std::vector<T> Type;
+
+        bool Changed() const override
+        {
+            return !this->_value.empty();
+        }
+
+        virtual ParamArrayEncoding Encoding() const
+        {
+            return ParamArrayText;
+        }
+
+    protected:
+        typedef Cpl::Param<Type> Base;
+        typedef Cpl::Param<int> Unknown;
+
+        static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "ParamArray supports only numeric types!");
+
+        ParamArray(const char* name)
+            : Base(name)
+        {
+        }
+
+        Unknown* End() const override
+        {
+            return (Unknown*)(this + 1);
+        }
+
+        bool EqualNode(const Unknown* other) const override
+        {
+            return this->_value == ((ParamArray*)other)->_value;
+        }
+
+        void CloneNode(const Unknown* other) override
+        {
+            this->_value = ((ParamArray*)other)->_value;
+        }
+
+        void DiffNode(const Unknown* other, const String& path, ParamPatch& patch) const override
+        {
+            if (!(this->_value == ((ParamArray*)other)->_value))
+                patch.Add(ParamPatch::OpSet, path, ((ParamArray*)other)->Encode());
+        }
+
+        bool ApplyNode(const ParamPatch::Change& change, size_t pos, ParamUndos& undos) override
+        {
+            if (pos != change.path.size() || change.op != ParamPatch::OpSet)
+                return false;
+            std::vector<T> previous = this->_value;
+            if (!Decode(change.value.c_str(), change.value.size()))
             {
-                if (current.Type() != Yaml::Node::ScalarType)
-                    return false;
-                T value;
-                Cpl::ToVal(current.As<String>(), value);
-                (*this)() = value;
+                this->_value.swap(previous);
+                return false;
+            }
+            undos.push_back(ParamUndo{ change.path, [previous](void* node) { ((ParamArray*)node)->_value = previous; } });
+            return true;
+        }
+
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
+        {
+            return Decode(xmlCurrent->Value(), xmlCurrent->ValueSize());
+        }
+
+        void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool) const override
+        {
+            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, this->Name());
+            String text = Encode();
+            xmlCurrent->Value(xmlDoc.AllocateString(text.c_str(), text.size() + 1), text.size());
+            xmlParent->AppendNode(xmlCurrent);
+        }
+
+        bool LoadCurrentYaml(Yaml::Node& current) override
+        {
+            if (current.Type() != Yaml::Node::ScalarType)
+                return false;
+            const String& string = current.AsString();
+            return Decode(string.c_str(), string.size());
+        }
+
+        void SaveNodeYaml(Yaml::Node& node, bool) const override
+        {
+            node[this->Name()] = Encode();
+        }
+
+        bool LoadCurrentJson(Json::Value& current) override
+        {
+            if (current.GetType() == Json::Value::StringType)
+                return Decode(current.Data(), current.Size());
+            if (current.GetType() != Json::Value::ArrayType)
+                return false;
+            this->_value.resize(current.Count());
+            T* value = this->_value.data();
+            for (Json::Value* item = current.First(); item; item = item->Next(), ++value)
+            {
+                if (!item->Scalar() || !ParseItem(item->Data(), item->Size(), *value))
+                    return Invalid();
+            }
+            return true;
+        }
+
+        void SaveNodeJson(Json::Writer& writer, bool) const override
+        {
+            writer.Key(this->Name());
+            if (Encoding() == ParamArrayBase64)
+            {
+                writer.Text(Encode());
+                return;
+            }
+            writer.BeginArray();
+            char buffer[BufferSize];
+            for (size_t i = 0; i < this->_value.size(); ++i)
+            {
+                int size = Print(buffer, this->_value[i]);
+                if (Json::IsNumber(buffer, size))
+                    writer.Number(buffer, size);
+                else
+                    writer.Text(buffer, size);
+            }
+            writer.EndArray();
+        }
+
+        String Encode() const
+        {
+            const Type& values = this->_value;
+            if (Encoding() == ParamArrayBase64)
+                return String(Prefix()) + ToBase64(values.data(), values.size() * sizeof(T));
+            String text;
+            text.reserve(values.size() * 8);
+            char buffer[BufferSize + 1];
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                buffer[0] = ' ';
+                text.append(buffer + (i ? 0 : 1), Print(buffer + 1, values[i]) + (i ? 1 : 0));
+            }
+            return text;
+        }
+
+        bool Decode(const char* data, size_t size)
+        {
+            Type& values = this->_value;
+            const char* end = data + size;
+            while (data < end && IsSpace(*data))
+                ++data;
+            size_t prefix = strlen(Prefix());
+            if (size_t(end - data) >= prefix && memcmp(data, Prefix(), prefix) == 0)
+            {
+                data += prefix;
+                values.resize((end - data) / 4 * 3 / sizeof(T) + 1);
+                ptrdiff_t decoded = FromBase64(data, end - data, values.data());
+                if (decoded < 0 || decoded % sizeof(T) != 0)
+                    return Invalid();
+                values.resize(decoded / sizeof(T));
+                return true;
+            }
+            values.clear();
+            while (data < end)
+            {
+                const char* item = data;
+                while (data < end && !IsSpace(*data) && *data != ',')
+                    ++data;
+                if (data > item)
+                {
+                    values.push_back(T());
+                    if (!ParseItem(item, data - item, values.back()))
+                        return Invalid();
+                }
+                while (data < end && (IsSpace(*data) || *data == ','))
+                    ++data;
             }
             return true;
         }
+
+    private:
+        enum { BufferSize = 64 };
+
+        bool Invalid()
+        {
+            this->_value.clear();
+            CPL_LOG_SS(Warning, "Can't decode array '" << this->Name() << "', it will be empty!");
+            return false;
+        }
+
+        static CPL_INLINE const char* Prefix()
+        {
+            return "base64:";
+        }
+
+        static CPL_INLINE bool IsSpace(char c)
+        {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+        }
+
+#if defined(__cpp_lib_to_chars)
+        static CPL_INLINE int Print(char* buffer, T value)
+        {
+            return int(std::to_chars(buffer, buffer + BufferSize, value).ptr - buffer);
+        }
+
+        static CPL_INLINE bool ParseItem(const char* data, size_t size, T& value)
+        {
+            const char* end = data + size;
+            if (size > 1 && *data == '+')
+                ++data;
+            std::from_chars_result result = std::from_chars(data, end, value);
+            return result.ec == std::errc() && result.ptr == end;
+        }
+#else
+        static CPL_INLINE int Print(char* buffer, float value) { return ::snprintf(buffer, BufferSize, "%.9g", value); }
+        static CPL_INLINE int Print(char* buffer, double value) { return ::snprintf(buffer, BufferSize, "%.17g", value); }
+        static CPL_INLINE int Print(char* buffer, long double value) { return ::snprintf(buffer, BufferSize, "%.21Lg", value); }
+
+        template<class U> static CPL_INLINE int Print(char* buffer, U value)
+        {
+            if (std::is_signed<U>::value)
+                return ::snprintf(buffer, BufferSize, "%lld", (long long)value);
+            else
+                return ::snprintf(buffer, BufferSize, "%llu", (unsigned long long)value);
+        }
+
+        static CPL_INLINE bool Scan(const char* str, char** end, float& value) { value = ::strtof(str, end); return true; }
+        static CPL_INLINE bool Scan(const char* str, char** end, double& value) { value = ::strtod(str, end); return true; }
+        static CPL_INLINE bool Scan(const char* str, char** end, long double& value) { value = ::strtold(str, end); return true; }
+
+        template<class U> static CPL_INLINE bool Scan(const char* str, char** end, U& value)
+        {
+            if (std::is_signed<U>::value)
+            {
+                long long val = ::strtoll(str, end, 10);
+                value = U(val);
+                return val >= (long long)std::numeric_limits<U>::min() && val <= (long long)std::numeric_limits<U>::max();
+            }
+            else
+            {
+                unsigned long long val = ::strtoull(str, end, 10);
+                value = U(val);
+                return *str != '-' && val <= (unsigned long long)std::numeric_limits<U>::max();
+            }
+        }
+
+        static CPL_INLINE bool ParseItem(const char* data, size_t size, T& value)
+        {
+            char buffer[BufferSize], * end;
+            if (size == 0 || size >= BufferSize)
+                return false;
+            memcpy(buffer, data, size);
+            buffer[size] = 0;
+            return Scan(buffer, &end, value) && end == buffer + size;
+        }
+#endif
     };
 
     //---------------------------------------------------------------------------------------------
@@ -454,7 +1927,7 @@ namespace Cpl
     {
         bool Changed() const override
         {
-            for (const Unknown* child = this->ChildBeg(); child < this->End(); child = child->End())
+            for (const Unknown* child = this->ChildBeg(); child < this->ChildEnd(); child = child->End())
             {
                 if (child->Changed())
                     return true;
@@ -466,7 +1939,7 @@ namespace Cpl
         typedef Cpl::Param<T> Base;
         typedef Cpl::Param<int> Unknown;
 
-        ParamStruct(const String& name)
+        ParamStruct(const char* name)
             : Base(name)
         {
         }
@@ -481,15 +1954,25 @@ namespace Cpl
             return (Unknown*)(&this->_value); 
         }
 
+        CPL_INLINE Unknown* ChildEnd() const
+        {
+            return (Unknown*)(&this->_value + 1);
+        }
+
+        bool MaterializeNode(bool recursive) override
+        {
+            return !recursive || Base::MaterializeRecord(this->ChildBeg(), this->ChildEnd());
+        }
+
         bool EqualNode(const Unknown* other) const override
         {
             const ParamStruct* that = (ParamStruct*)other;
             for (Unknown* tc = this->ChildBeg(), *oc = that->ChildBeg();; tc = tc->End(), oc = oc->End())
             {
-                if (tc >= this->End())
-                    return oc >= that->End();
-                if (oc >= that->End())
-                    return tc >= this->End();
+                if (tc >= this->ChildEnd())
+                    return oc >= that->ChildEnd();
+                if (oc >= that->ChildEnd())
+                    return tc >= this->ChildEnd();
                 if (!tc->EqualNode(oc))
                     return false;
             }
@@ -499,28 +1982,35 @@ namespace Cpl
         void CloneNode(const Unknown * other) override
         {
             const ParamStruct* that = (ParamStruct*)other;
-            for (Unknown* tc = this->ChildBeg(), *oc = that->ChildBeg(); tc < this->End(); tc = tc->End(), oc = oc->End())
+            for (Unknown* tc = this->ChildBeg(), *oc = that->ChildBeg(); tc < this->ChildEnd(); tc = tc->End(), oc = oc->End())
                 tc->CloneNode(oc);
         }
 
-        bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
+        void DiffNode(const Unknown* other, const String& path, ParamPatch& patch) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlParent->FirstNode(this->Name().c_str());
-            if (xmlCurrent)
-            {
-                for (Unknown* paramChild = this->ChildBeg(); paramChild < this->End(); paramChild = paramChild->End())
-                {
-                    if (!paramChild->LoadNodeXml(xmlCurrent))
-                        return true;
-                }
-            }
+            Base::DiffRecord(this->ChildBeg(), this->ChildEnd(), ((ParamStruct*)other)->ChildBeg(), path, patch);
+        }
+
+        bool ApplyNode(const ParamPatch::Change& change, size_t pos, ParamUndos& undos) override
+        {
+            return Base::ApplyRecord(this->ChildBeg(), this->ChildEnd(), change, pos, undos);
+        }
+
+        Unknown* FindNode(const String& path, size_t pos) override
+        {
+            return pos == path.size() ? (Unknown*)this : Base::FindRecord(this->ChildBeg(), this->ChildEnd(), path, pos);
+        }
+
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
+        {
+            Base::template LoadRecordXml<T>(this->ChildBeg(), this->ChildEnd(), xmlCurrent);
             return true;
         }
 
         void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(this->Name().c_str()));
-            for (const Unknown* paramChild = this->ChildBeg(); paramChild < this->End(); paramChild = paramChild->End())
+            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, this->Name());
+            for (const Unknown* paramChild = this->ChildBeg(); paramChild < this->ChildEnd(); paramChild = paramChild->End())
             {
                 if (full || paramChild->Changed())
                     paramChild->SaveNodeXml(xmlDoc, xmlCurrent, full);
@@ -528,33 +2018,40 @@ namespace Cpl
             xmlParent->AppendNode(xmlCurrent);
         }
 
-        bool LoadNodeYaml(Yaml::Node& node) override
+        bool LoadCurrentYaml(Yaml::Node& current) override
         {
-            Yaml::Node & current = node[this->Name()];
-            if (current.Type() != Yaml::Node::None)
+            if (current.Type() != Yaml::Node::MapType)
+                return false;
+            Base::template LoadRecordYaml<T>(this->ChildBeg(), this->ChildEnd(), current);
+            return true;
+        }
+
+        void SaveNodeYaml(Yaml::Node& node, bool full) const override
+        {
+            Yaml::Node& current = node[this->Name()];
+            for (const Unknown* paramChild = this->ChildBeg(); paramChild < this->ChildEnd(); paramChild = paramChild->End())
             {
-                if (current.Type() != Yaml::Node::MapType)
-                    return false;
-                for (Unknown* paramChild = this->ChildBeg(); paramChild < this->End(); paramChild = paramChild->End())
-                {
-                    if (!paramChild->LoadNodeYaml(current))
-                        return true;
-                }
+                if (full || paramChild->Changed())
+                    paramChild->SaveNodeYaml(current, full);
             }
+        }
+
+        bool LoadCurrentJson(Json::Value& current) override
+        {
+            if (current.GetType() != Json::Value::ObjectType)
+                return false;
+            Base::template LoadRecordJson<T>(this->ChildBeg(), this->ChildEnd(), current);
             return true;
         }
 
-        void SaveNodeYaml(Yaml::Node& node, bool full) const override
+        void SaveNodeJson(Json::Writer& writer, bool full) const override
         {
-            Yaml::Node& current = node[this->Name()];
-            for (const Unknown* paramChild = this->ChildBeg(); paramChild < this->End(); paramChild = paramChild->End())
-            {
-                if (full || paramChild->Changed())
-                    paramChild->SaveNodeYaml(current, full);
-            }
+            writer.Key(this->Name());
+            Base::SaveRecordJson(this->ChildBeg(), this->ChildEnd(), writer, full);
         }
 
         template<typename> friend struct ParamStorage;
+        template<typename> friend class ParamSnapshot;
     };
 
     //---------------------------------------------------------------------------------------------
@@ -570,7 +2067,7 @@ namespace Cpl
         typedef Cpl::Param<std::vector<T>> Base;
         typedef Cpl::Param<int> Unknown;
 
-        ParamVector(const String& name)
+        ParamVector(const char* name)
             : Base(name)
         {
         }
@@ -597,6 +2094,14 @@ namespace Cpl
             return (Unknown*)(this->_value.data() + index);
         }
 
+        bool MaterializeNode(bool recursive) override
+        {
+            bool result = true;
+            for (size_t i = 0; recursive && i < Size(); ++i)
+                result = Base::MaterializeRecord(this->ChildBeg(i), this->ChildBeg(i + 1)) && result;
+            return result;
+        }
+
         bool EqualNode(const Unknown* other) const override
         {
             const ParamVector* that = (ParamVector*)other;
@@ -618,33 +2123,91 @@ namespace Cpl
                 tc->CloneNode(oc);
         }
 
-        bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
+        void DiffNode(const Unknown* other, const String& path, ParamPatch& patch) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlParent->FirstNode(this->Name().c_str());
-            if (xmlCurrent)
+            const ParamVector* that = (ParamVector*)other;
+            if (this->Size() != that->Size())
+                patch.Add(ParamPatch::OpResize, path, Cpl::ToStr(that->Size()));
+            for (size_t i = 0; i < that->Size(); ++i)
             {
-                Resize(Xml::CountChildren(xmlCurrent));
-                Xml::XmlNode<char>* xmlItem = xmlCurrent->FirstNode();
-                for (size_t i = 0; i < Size(); ++i)
+                String itemPath = ParamPatch::Append(path, Cpl::ToStr(i));
+                if (i < this->Size())
+                    Base::DiffRecord(this->ChildBeg(i), this->ChildBeg(i + 1), that->ChildBeg(i), itemPath, patch);
+                else
                 {
-                    if (ItemName() != xmlItem->Name())
-                        return false;
-                    Unknown* paramChild = this->ChildBeg(i);
-                    const Unknown* paramChildEnd = this->ChildBeg(i + 1);
-                    for (; paramChild < paramChildEnd; paramChild = paramChild->End())
-                    {
-                        if (!paramChild->LoadNodeXml(xmlItem))
-                            return true;
-                    }
-                    xmlItem = xmlItem->NextSibling();
+                    T item;
+                    Base::DiffRecord((Unknown*)&item, (Unknown*)(&item + 1), that->ChildBeg(i), itemPath, patch);
                 }
             }
-            return true;
+        }
+
+        bool ApplyNode(const ParamPatch::Change& change, size_t pos, ParamUndos& undos) override
+        {
+            if (pos == change.path.size())
+            {
+                if (change.op != ParamPatch::OpResize)
+                    return false;
+                size_t size = 0;
+                if (!Cpl::TryToVal(change.value, size))
+                    return false;
+                std::vector<T> removed(this->_value.begin() + std::min(size, Size()), this->_value.end());
+                size_t previous = Size();
+                undos.push_back(ParamUndo{ change.path, [previous, removed](void* node)
+                {
+                    ParamVector* vector = (ParamVector*)node;
+                    vector->Resize(previous - removed.size());
+                    vector->_value.insert(vector->_value.end(), removed.begin(), removed.end());
+                } });
+                Resize(size);
+                return true;
+            }
+            String segment;
+            size_t index = 0;
+            if (!ParamPatch::Next(change.path, pos, segment) || !Cpl::TryToVal(segment, index) || index >= this->Size())
+                return false;
+            return Base::ApplyRecord(this->ChildBeg(index), this->ChildBeg(index + 1), change, pos, undos);
+        }
+
+        Unknown* FindNode(const String& path, size_t pos) override
+        {
+            if (pos == path.size())
+                return (Unknown*)this;
+            String segment;
+            size_t index = 0;
+            if (!ParamPatch::Next(path, pos, segment) || !Cpl::TryToVal(segment, index) || index >= this->Size())
+                return NULL;
+            return Base::FindRecord(this->ChildBeg(index), this->ChildBeg(index + 1), path, pos);
+        }
+
+        template<class N> bool LoadItems(const std::vector<N*>& nodes, size_t size)
+        {
+            size_t threads = ParamLoadThreads::Get(nodes.size());
+            std::vector<T*> records(nodes.size());
+            for (size_t i = 0; i < records.size(); ++i)
+                records[i] = this->_value.data() + i;
+            return Base::LoadRecords(records.data(), nodes.data(), nodes.size(), threads, size) == nodes.size();
+        }
+
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
+        {
+            size_t size = Size();
+            Resize(Xml::CountChildren(xmlCurrent));
+            std::vector<Xml::XmlNode<char>*> xmlItems;
+            xmlItems.reserve(Size());
+            for (Xml::XmlNode<char>* xmlItem = xmlCurrent->FirstNode(); xmlItems.size() < Size(); xmlItem = xmlItem->NextSibling())
+            {
+                if (ItemName() != xmlItem->Name())
+                    break;
+                xmlItems.push_back(xmlItem);
+            }
+            if (!LoadItems(xmlItems, size))
+                return true;
+            return xmlItems.size() == Size();
         }
 
         void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(this->Name().c_str()));
+            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, this->Name());
             for (size_t i = 0; i < Size(); ++i)
             {
                 const Unknown* paramChild = this->ChildBeg(i);
@@ -660,25 +2223,16 @@ namespace Cpl
             xmlParent->AppendNode(xmlCurrent);
         }
 
-        bool LoadNodeYaml(Yaml::Node& node) override
+        bool LoadCurrentYaml(Yaml::Node& current) override
         {
-            Yaml::Node& current = node[this->Name()];
-            if (current.Type() != Yaml::Node::None)
-            {
-                if (current.Type() != Yaml::Node::SequenceType)
-                    return false;
-                Resize(current.Size());
-                for (size_t i = 0; i < Size(); ++i)
-                {
-                    Unknown* paramChild = this->ChildBeg(i);
-                    const Unknown* paramChildEnd = this->ChildBeg(i + 1);
-                    for (; paramChild < paramChildEnd; paramChild = paramChild->End())
-                    {
-                        if (!paramChild->LoadNodeYaml(current[i]))
-                            return true;
-                    }
-                }
-            }
+            if (current.Type() != Yaml::Node::SequenceType)
+                return false;
+            size_t size = Size();
+            Resize(current.Size());
+            std::vector<Yaml::Node*> items(Size());
+            for (size_t i = 0; i < Size(); ++i)
+                items[i] = &current[i];
+            LoadItems(items, size);
             return true;
         }
 
@@ -703,8 +2257,175 @@ namespace Cpl
                     this->ChildBeg(i)->SaveNodeYaml(childNode, full);
             }
         }
+
+        bool LoadCurrentJson(Json::Value& current) override
+        {
+            if (current.GetType() != Json::Value::ArrayType)
+                return false;
+            size_t size = Size();
+            Resize(current.Count());
+            std::vector<Json::Value*> items;
+            items.reserve(Size());
+            for (Json::Value* item = current.First(); items.size() < Size(); item = item->Next())
+            {
+                if (item->GetType() != Json::Value::ObjectType)
+                    break;
+                items.push_back(item);
+            }
+            if (!LoadItems(items, size))
+                return true;
+            return items.size() == Size();
+        }
+
+        void SaveNodeJson(Json::Writer& writer, bool full) const override
+        {
+            writer.Key(this->Name());
+            writer.BeginArray();
+            for (size_t i = 0; i < Size(); ++i)
+                Base::SaveRecordJson(this->ChildBeg(i), this->ChildBeg(i + 1), writer, full);
+            writer.EndArray();
+        }
+    };
+
+    //---------------------------------------------------------------------------------------------
+
+    /*
+    * Node which can defer its loading in Param::LoadLazy (it is declared by CPL_PARAM_STRUCT_LAZY and CPL_PARAM_VECTOR_LAZY).
+    * Plain nodes are always loaded at once and don't pay for the deferred state.
+    */
+    template<class Node> struct ParamLazyNode : public Node
+    {
+        typedef typename Node::Type Type;
+
+        CPL_INLINE const Type& operator () () const
+        {
+            Resolve();
+            return this->_value;
+        }
+
+        CPL_INLINE Type& operator () ()
+        {
+            Resolve();
+            return this->_value;
+        }
+
+        bool Changed() const override
+        {
+            Resolve();
+            return Node::Changed();
+        }
+
+    protected:
+        typedef Cpl::Param<int> Unknown;
+
+        mutable ParamLazy _lazy;
+
+        ParamLazyNode(const char* name)
+            : Node(name)
+        {
+        }
+
+        Unknown* End() const override
+        {
+            return (Unknown*)(this + 1);
+        }
+
+        CPL_INLINE void Resolve() const
+        {
+            if (_lazy.Pending())
+                _lazy.Resolve([this](ParamFormat format, void* node) { return ((ParamLazyNode*)this)->LoadNow(format, node); });
+        }
+
+        bool LoadNow(ParamFormat format, void* node)
+        {
+            if (format == ParamFormatXml)
+                return Node::LoadCurrentXml((Xml::XmlNode<char>*)node);
+            else if (format == ParamFormatYaml)
+                return Node::LoadCurrentYaml(*(Yaml::Node*)node);
+            else
+                return Node::LoadCurrentJson(*(Json::Value*)node);
+        }
+
+        bool MaterializeNode(bool recursive) override
+        {
+            Resolve();
+            return Node::MaterializeNode(recursive) && !_lazy.Failed();
+        }
+
+        bool EqualNode(const Unknown* other) const override
+        {
+            Resolve();
+            ((ParamLazyNode*)other)->Resolve();
+            return Node::EqualNode(other);
+        }
+
+        void CloneNode(const Unknown* other) override
+        {
+            Resolve();
+            ((ParamLazyNode*)other)->Resolve();
+            Node::CloneNode(other);
+        }
+
+        void DiffNode(const Unknown* other, const String& path, ParamPatch& patch) const override
+        {
+            Resolve();
+            ((ParamLazyNode*)other)->Resolve();
+            Node::DiffNode(other, path, patch);
+        }
+
+        bool ApplyNode(const ParamPatch::Change& change, size_t pos, ParamUndos& undos) override
+        {
+            Resolve();
+            return Node::ApplyNode(change, pos, undos);
+        }
+
+        Unknown* FindNode(const String& path, size_t pos) override
+        {
+            Resolve();
+            return Node::FindNode(path, pos);
+        }
+
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
+        {
+            Resolve();
+            return _lazy.Defer(xmlCurrent) || Node::LoadCurrentXml(xmlCurrent);
+        }
+
+        void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const override
+        {
+            Resolve();
+            Node::SaveNodeXml(xmlDoc, xmlParent, full);
+        }
+
+        bool LoadCurrentYaml(Yaml::Node& current) override
+        {
+            Resolve();
+            return _lazy.Defer(&current) || Node::LoadCurrentYaml(current);
+        }
+
+        void SaveNodeYaml(Yaml::Node& node, bool full) const override
+        {
+            Resolve();
+            Node::SaveNodeYaml(node, full);
+        }
+
+        bool LoadCurrentJson(Json::Value& current) override
+        {
+            Resolve();
+            return _lazy.Defer(&current) || Node::LoadCurrentJson(current);
+        }
+
+        void SaveNodeJson(Json::Writer& writer, bool full) const override
+        {
+            Resolve();
+            Node::SaveNodeJson(writer, full);
+        }
     };
 
+    template<class T> using ParamLazyStruct = ParamLazyNode<ParamStruct<T>>;
+
+    template<class T> using ParamLazyVector = ParamLazyNode<ParamVector<T>>;
+
     //---------------------------------------------------------------------------------------------
 
     template<class K, class T> struct ParamMap : public Cpl::Param<std::map<K, T>>
@@ -719,7 +2440,7 @@ namespace Cpl
         typedef Cpl::Param<int> Unknown;
         typedef std::map<K, T> Map;
 
-        ParamMap(const String& name)
+        ParamMap(const char* name)
             : Base(name)
         {
         }
@@ -743,6 +2464,14 @@ namespace Cpl
             return (Unknown*)(&value + 1);
         }
 
+        bool MaterializeNode(bool recursive) override
+        {
+            bool result = true;
+            for (typename Map::iterator it = this->_value.begin(); recursive && it != this->_value.end(); ++it)
+                result = Base::MaterializeRecord(ChildBeg(it->second), ChildEnd(it->second)) && result;
+            return result;
+        }
+
         bool EqualNode(const Unknown* other) const override
         {
             const ParamMap* that = (ParamMap*)other;
@@ -784,44 +2513,140 @@ namespace Cpl
             }
         }
 
-        bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
+        void DiffNode(const Unknown* other, const String& path, ParamPatch& patch) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlParent->FirstNode(this->Name().c_str());
-            if (xmlCurrent)
+            const ParamMap* that = (ParamMap*)other;
+            typename Map::key_compare less = this->_value.key_comp();
+            typename Map::const_iterator t = this->_value.begin(), o = that->_value.begin();
+            while (t != this->_value.end() || o != that->_value.end())
             {
-                size_t size = Xml::CountChildren(xmlCurrent);
-                Xml::XmlNode<char>* xmlItem = xmlCurrent->FirstNode();
-                for (size_t i = 0; i < size; ++i)
+                if (o == that->_value.end() || (t != this->_value.end() && less(t->first, o->first)))
                 {
-                    if (ItemName() != xmlItem->Name())
-                        return false;
-                    Xml::XmlNode<char>* xmlKey = xmlItem->FirstNode(KeyName().c_str());
-                    if (xmlKey)
-                    {
-                        K key;
-                        Cpl::ToVal(xmlKey->Value(), key);
-                        T & value = this->_value[key];
-                        Xml::XmlNode<char>* xmlValue = xmlItem->FirstNode(ValueName().c_str());
-                        if (xmlValue)
-                        {
-                            Unknown* paramChild = ChildBeg(value);
-                            Unknown* paramChildEnd = ChildEnd(value);
-                            for (; paramChild < paramChildEnd; paramChild = paramChild->End())
-                            {
-                                if (!paramChild->LoadNodeXml(xmlValue))
-                                    return true;
-                            }
-                        }
-                    }
-                    xmlItem = xmlItem->NextSibling();
+                    patch.Add(ParamPatch::OpErase, ParamPatch::Append(path, Cpl::ToStr(t->first)));
+                    ++t;
+                }
+                else if (t == this->_value.end() || less(o->first, t->first))
+                {
+                    String itemPath = ParamPatch::Append(path, Cpl::ToStr(o->first));
+                    patch.Add(ParamPatch::OpInsert, itemPath);
+                    T value;
+                    Base::DiffRecord(ChildBeg(value), ChildEnd(value), that->ChildBeg(o->second), itemPath, patch);
+                    ++o;
+                }
+                else
+                {
+                    String itemPath = ParamPatch::Append(path, Cpl::ToStr(o->first));
+                    Base::DiffRecord(ChildBeg(t->second), ChildEnd(t->second), that->ChildBeg(o->second), itemPath, patch);
+                    ++t, ++o;
+                }
+            }
+        }
+
+        bool ApplyNode(const ParamPatch::Change& change, size_t pos, ParamUndos& undos) override
+        {
+            String segment;
+            size_t start = pos;
+            if (!ParamPatch::Next(change.path, pos, segment))
+                return false;
+            K key;
+            if (!Cpl::TryToVal(segment, key))
+                return false;
+            typename Map::iterator it = this->_value.find(key);
+            if (pos == change.path.size())
+            {
+                if (change.op != ParamPatch::OpInsert && change.op != ParamPatch::OpErase)
+                    return false;
+                bool existed = it != this->_value.end();
+                T previous = existed ? it->second : T();
+                undos.push_back(ParamUndo{ change.path.substr(0, start), [key, existed, previous](void* node)
+                {
+                    ParamMap* map = (ParamMap*)node;
+                    if (existed)
+                        map->_value[key] = previous;
+                    else
+                        map->_value.erase(key);
+                } });
+                if (change.op == ParamPatch::OpInsert)
+                    this->_value[key] = T();
+                else
+                    this->_value.erase(key);
+                return true;
+            }
+            if (it == this->_value.end())
+                return false;
+            return Base::ApplyRecord(ChildBeg(it->second), ChildEnd(it->second), change, pos, undos);
+        }
+
+        Unknown* FindNode(const String& path, size_t pos) override
+        {
+            if (pos == path.size())
+                return (Unknown*)this;
+            String segment;
+            K key;
+            if (!ParamPatch::Next(path, pos, segment) || !Cpl::TryToVal(segment, key))
+                return NULL;
+            typename Map::iterator it = this->_value.find(key);
+            return it == this->_value.end() ? NULL : Base::FindRecord(ChildBeg(it->second), ChildEnd(it->second), path, pos);
+        }
+
+        template<class N> bool LoadItems(const std::vector<K>& keys, const std::vector<N*>& nodes)
+        {
+            size_t size = keys.size(), i = 0;
+            if (ParamLoadThreads::Get(size) > 1)
+            {
+                std::vector<T*> records;
+                records.reserve(size);
+                for (; i < size; ++i)
+                {
+                    std::pair<typename Map::iterator, bool> inserted = this->_value.insert(typename Map::value_type(keys[i], T()));
+                    if (!inserted.second)
+                        break;
+                    records.push_back(&inserted.first->second);
+                }
+                size_t stop = Base::LoadRecords(records.data(), nodes.data(), i, ParamLoadThreads::Get(i), 0);
+                if (stop < i)
+                {
+                    for (size_t j = stop + 1; j < i; ++j)
+                        this->_value.erase(keys[j]);
+                    return false;
                 }
             }
+            for (; i < size; ++i)
+            {
+                T& value = this->_value[keys[i]];
+                if (nodes[i] && !Base::LoadRecord(value, nodes[i]))
+                    return false;
+            }
             return true;
         }
 
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
+        {
+            size_t size = Xml::CountChildren(xmlCurrent), i = 0;
+            std::vector<K> keys;
+            std::vector<Xml::XmlNode<char>*> xmlValues;
+            Xml::XmlNode<char>* xmlItem = xmlCurrent->FirstNode();
+            for (; i < size; ++i, xmlItem = xmlItem->NextSibling())
+            {
+                if (ItemName() != xmlItem->Name())
+                    break;
+                Xml::XmlNode<char>* xmlKey = xmlItem->FirstNode(KeyName().c_str());
+                if (xmlKey)
+                {
+                    K key;
+                    Cpl::ToVal(Xml::ExpandedValue(xmlKey), key);
+                    keys.push_back(key);
+                    xmlValues.push_back(xmlItem->FirstNode(ValueName().c_str()));
+                }
+            }
+            if (!LoadItems(keys, xmlValues))
+                return true;
+            return i == size;
+        }
+
         void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(this->Name().c_str()));
+            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, this->Name());
             for (typename Map::const_iterator it = this->_value.begin(); it != this->_value.end(); ++it)
             {
                 Xml::XmlNode<char>* xmlItem = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(ItemName().c_str()));
@@ -845,30 +2670,20 @@ namespace Cpl
             xmlParent->AppendNode(xmlCurrent);
         }
 
-        bool LoadNodeYaml(Yaml::Node& node) override
+        bool LoadCurrentYaml(Yaml::Node& current) override
         {
-            Yaml::Node& current = node[this->Name()];
-            if (current.Type() != Yaml::Node::None)
+            if (current.Type() != Yaml::Node::MapType)
+                return false;
+            std::vector<K> keys;
+            std::vector<Yaml::Node*> items;
+            for (Yaml::Iterator it = current.Begin(), end = current.End(); it != end; it++)
             {
-                if (current.Type() != Yaml::Node::MapType)
-                    return false;
-                for (Yaml::Iterator it = current.Begin(), end = current.End(); it != end; it++)
-                {
-                    K key;
-                    Cpl::ToVal((*it).first, key);
-                    T& value = this->_value[key];
-                    if ((*it).second.Type() != Yaml::Node::None)
-                    {
-                        Unknown* paramChild = ChildBeg(value);
-                        Unknown* paramChildEnd = ChildEnd(value);
-                        for (; paramChild < paramChildEnd; paramChild = paramChild->End())
-                        {
-                            if (!paramChild->LoadNodeYaml((*it).second))
-                                return true;
-                        }
-                    }
-                }
+                K key;
+                Cpl::ToVal((*it).first, key);
+                keys.push_back(key);
+                items.push_back((*it).second.Type() != Yaml::Node::None ? &(*it).second : NULL);
             }
+            LoadItems(keys, items);
             return true;
         }
 
@@ -893,6 +2708,39 @@ namespace Cpl
                     this->ChildBeg(it->second)->SaveNodeYaml(childNode, full);
             }
         }
+
+        bool LoadCurrentJson(Json::Value& current) override
+        {
+            if (current.GetType() != Json::Value::ObjectType)
+                return false;
+            std::vector<K> keys;
+            std::vector<Json::Value*> items;
+            Json::Value* item = current.First();
+            for (; item; item = item->Next())
+            {
+                K key;
+                Cpl::ToVal(String(item->Name(), item->NameSize()), key);
+                keys.push_back(key);
+                items.push_back(item->GetType() == Json::Value::ObjectType ? item : NULL);
+                if (item->GetType() != Json::Value::ObjectType && item->GetType() != Json::Value::NullType)
+                    break;
+            }
+            if (!LoadItems(keys, items))
+                return true;
+            return item == NULL;
+        }
+
+        void SaveNodeJson(Json::Writer& writer, bool full) const override
+        {
+            writer.Key(this->Name());
+            writer.BeginObject();
+            for (typename Map::const_iterator it = this->_value.begin(); it != this->_value.end(); ++it)
+            {
+                writer.Key(Cpl::ToStr(it->first).c_str());
+                Base::SaveRecordJson(this->ChildBeg(it->second), this->ChildEnd(it->second), writer, full);
+            }
+            writer.EndObject();
+        }
     };
 
     //---------------------------------------------------------------------------------------------
@@ -913,6 +2761,67 @@ namespace Cpl
             data = end;
         }
     }
+
+    //---------------------------------------------------------------------------------------------
+
+    class EnumTable
+    {
+    public:
+        EnumTable(const char* data, size_t prefix)
+        {
+            ParseEnumNames(data, _names);
+            for (size_t i = 0; i < _names.size(); ++i)
+            {
+                _names[i].erase(0, std::min(prefix, _names[i].size()));
+                _sorted.push_back(Item(ToLowerCase(_names[i]), int(i)));
+            }
+            std::sort(_sorted.begin(), _sorted.end());
+        }
+
+        CPL_INLINE const String& Name(int value) const
+        {
+            return value >= 0 && value < (int)_names.size() ? _names[value] : _empty;
+        }
+
+        int Find(const char* name, size_t size) const
+        {
+            size_t lo = 0, hi = _sorted.size();
+            while (lo < hi)
+            {
+                size_t mid = (lo + hi) / 2;
+                int compare = Compare(_sorted[mid].first, name, size);
+                if (compare == 0)
+                    return _sorted[mid].second;
+                if (compare < 0)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return -1;
+        }
+
+    private:
+        typedef std::pair<String, int> Item;
+
+        Strings _names;
+        std::vector<Item> _sorted;
+        String _empty;
+
+        static int Compare(const String& lower, const char* name, size_t size)
+        {
+            for (size_t i = 0, n = std::min(lower.size(), size); i < n; ++i)
+            {
+                unsigned char a = lower[i], b = name[i];
+                if (b <= 'Z' && b >= 'A')
+                    b = b - ('Z' - 'z');
+                if (a != b)
+                    return a < b ? -1 : 1;
+            }
+            return lower.size() < size ? -1 : (lower.size() > size ? 1 : 0);
+        }
+    };
+
+    template<class Enum> const EnumTable& GetEnumTable();
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -935,6 +2844,14 @@ struct Param_##name : public Cpl::ParamLimited<type> \
     type Max() const override { return max; } \
 } name;
 
+#define CPL_PARAM_ARRAY(type, name, encoding) \
+struct Param_##name : public Cpl::ParamArray<type> \
+{ \
+    typedef Cpl::ParamArray<type> Base; \
+    Param_##name() : Base(#name) {} \
+    Cpl::ParamArrayEncoding Encoding() const override { return encoding; } \
+} name;
+
 #define CPL_PARAM_STRUCT(type, name) \
 struct Param_##name : public Cpl::ParamStruct<type> \
 { \
@@ -956,6 +2873,20 @@ struct Param_##name : public Cpl::ParamVector<type> \
     Param_##name() : Base(#name) {} \
 } name;
 
+#define CPL_PARAM_STRUCT_LAZY(type, name) \
+struct Param_##name : public Cpl::ParamLazyStruct<type> \
+{ \
+    typedef Cpl::ParamLazyStruct<type> Base; \
+    Param_##name() : Base(#name) {} \
+} name;
+
+#define CPL_PARAM_VECTOR_LAZY(type, name) \
+struct Param_##name : public Cpl::ParamLazyVector<type> \
+{ \
+    typedef Cpl::ParamLazyVector<type> Base; \
+    Param_##name() : Base(#name) {} \
+} name;
+
 #define CPL_PARAM_MAP(key, type, name) \
 struct Param_##name : public Cpl::ParamMap<key, type> \
 { \
@@ -974,16 +2905,29 @@ enum type \
 #define CPL_PARAM_ENUM_CONV(ns, type, unknown, size, ...) \
 namespace Cpl \
 {\
+    template<> CPL_INLINE const Cpl::EnumTable& GetEnumTable<ns::type>() \
+    {\
+        static const Cpl::EnumTable table(#__VA_ARGS__, sizeof(#type) - 1); \
+        return table; \
+    }\
+    \
     template<> CPL_INLINE Cpl::String ToStr<ns::type>(const ns::type& value) \
     {\
-        static thread_local Cpl::Strings names; \
-        Cpl::ParseEnumNames(#__VA_ARGS__, names); \
-        return (value > ns::type##unknown && value < ns::type##size) ? names[value].substr(sizeof(#type) - 1) : Cpl::String(); \
+        return Cpl::GetEnumTable<ns::type>().Name(value); \
     }\
     \
     template<> CPL_INLINE void ToVal<ns::type>(const Cpl::String& string, ns::type& value)\
     {\
-        value = Cpl::ToEnum<ns::type, ns::type##size>(string); \
+        value = (ns::type)Cpl::GetEnumTable<ns::type>().Find(string.c_str(), string.length()); \
+    }\
+    \
+    template<> CPL_INLINE bool TryToVal<ns::type>(const Cpl::String& string, ns::type& value)\
+    {\
+        int index = Cpl::GetEnumTable<ns::type>().Find(string.c_str(), string.length()); \
+        if (index < 0) \
+            return false; \
+        value = (ns::type)index; \
+        return true; \
     }\
 }
 
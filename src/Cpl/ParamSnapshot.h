@@ -0,0 +1,179 @@
+/*
+* Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include "Cpl/Param.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+
+namespace Cpl
+{
+    /*
+    * Holds the current immutable snapshot of parameters (T is a type declared by CPL_PARAM_HOLDER).
+    * A new snapshot is loaded aside and published atomically, old snapshots are released
+    * when the last reader drops its pointer. Reader caches the pointer and checks only the version counter.
+    * Callbacks are called in order of publishing, outside of the callback lock: they may add or remove callbacks
+    * (a removed callback can still get the notification which is being delivered), but must not publish.
+    */
+    template<class T> class ParamSnapshot
+    {
+    public:
+        typedef std::shared_ptr<const T> Pointer;
+
+        typedef void(*Callback)(const Pointer& previous, const Pointer& current, const Strings& changed, void* userData);
+
+        class Reader
+        {
+        public:
+            Reader(const ParamSnapshot& snapshot)
+                : _snapshot(snapshot)
+                , _version(0)
+            {
+            }
+
+            CPL_INLINE const T& operator () ()
+            {
+                return *Get();
+            }
+
+            CPL_INLINE const Pointer& Get()
+            {
+                size_t version = _snapshot.Version();
+                if (version != _version)
+                {
+                    _current = _snapshot.Current();
+                    _version = version;
+                }
+                return _current;
+            }
+
+        private:
+            const ParamSnapshot& _snapshot;
+            Pointer _current;
+            size_t _version;
+        };
+
+        ParamSnapshot()
+            : _current(std::make_shared<const T>())
+            , _version(1)
+            , _callbackId(0)
+        {
+        }
+
+        CPL_INLINE Pointer Current() const
+        {
+            return std::atomic_load(&_current);
+        }
+
+        CPL_INLINE size_t Version() const
+        {
+            return _version.load(std::memory_order_acquire);
+        }
+
+        bool Load(const String& path, ParamFormat format = ParamFormatByExt)
+        {
+            std::shared_ptr<T> next = std::make_shared<T>();
+            if (!next->Load(path, format))
+                return false;
+            Publish(std::move(next));
+            return true;
+        }
+
+        bool Load(const char* data, size_t size, ParamFormat format)
+        {
+            std::shared_ptr<T> next = std::make_shared<T>();
+            if (!next->Load(data, size, format))
+                return false;
+            Publish(std::move(next));
+            return true;
+        }
+
+        std::future<bool> LoadAsync(const String& path, ParamFormat format = ParamFormatByExt)
+        {
+            return std::async(std::launch::async, [this, path, format]() { return this->Load(path, format); });
+        }
+
+        void Publish(std::shared_ptr<T>&& next)
+        {
+            std::lock_guard<std::mutex> publish(_publish);
+            Pointer previous = std::atomic_load(&_current), current = std::move(next);
+            Strings changed;
+            for (const Unknown* pc = previous->ChildBeg(), *cc = current->ChildBeg(); pc < previous->End(); pc = pc->End(), cc = cc->End())
+            {
+                if (!pc->EqualNode(cc))
+                    changed.push_back(pc->Name());
+            }
+            std::atomic_store(&_current, current);
+            _version.fetch_add(1, std::memory_order_release);
+            if (changed.empty())
+                return;
+            Callbacks callbacks;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                callbacks = _callbacks;
+            }
+            for (typename Callbacks::const_iterator it = callbacks.begin(); it != callbacks.end(); ++it)
+                it->second.callback(previous, current, changed, it->second.userData);
+        }
+
+        int AddCallback(Callback callback, void* userData)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _callbacks[++_callbackId] = Subscriber(callback, userData);
+            return _callbackId;
+        }
+
+        void RemoveCallback(int id)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _callbacks.erase(id);
+        }
+
+    private:
+        typedef Cpl::Param<int> Unknown;
+
+        struct Subscriber
+        {
+            Callback callback;
+            void* userData;
+
+            Subscriber(Callback c = NULL, void* u = NULL)
+                : callback(c)
+                , userData(u)
+            {
+            }
+        };
+        typedef std::map<int, Subscriber> Callbacks;
+
+        Pointer _current;
+        std::atomic<size_t> _version;
+        std::mutex _publish, _mutex;
+        Callbacks _callbacks;
+        int _callbackId;
+    };
+}
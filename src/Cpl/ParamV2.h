@@ -34,59 +34,50 @@ namespace Cpl
     protected:
         typedef Cpl::Param<int> Unknown;
 
-        ParamVectorV2(const String& name)
+        ParamVectorV2(const char* name)
             : ParamVector<T>(name)
         {
         }
 
         CPL_INLINE String CountName() const { return "count"; }
 
-        bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlParent->FirstNode(this->Name().c_str());
-            if (xmlCurrent)
+            auto countName = CountName();
+            auto itemName = Cpl::ParamVector<T>::ItemName();
+            size_t itemCount = Xml::CountChildren(xmlCurrent, itemName.c_str(), itemName.size());
+            size_t childrenCount = Xml::CountChildren(xmlCurrent);
+
+            auto* countNode = xmlCurrent->FirstNode(countName.c_str(), countName.size());
+            // 0 or 1 'count' node allowed
+            if (countNode)
             {
-                auto countName = CountName();
-                auto itemName = Cpl::ParamVector<T>::ItemName();
-                size_t itemCount = Xml::CountChildren(xmlCurrent, itemName.c_str(), itemName.size());
-                size_t childrenCount = Xml::CountChildren(xmlCurrent);
-
-                auto* countNode = xmlCurrent->FirstNode(countName.c_str(), countName.size());
-                // 0 or 1 'count' node allowed
-                if (countNode)
-                {
-                    if (itemCount != childrenCount - 1)
-                        return false;
-
-                    int count = 0;
-                    Cpl::ToVal(countNode->Value(), count);
-                    if (count != itemCount)
-                        return false;
-                }
-                else if (itemCount != childrenCount)
+                if (itemCount != childrenCount - 1)
                     return false;
-                Cpl::ParamVector<T>::Resize(itemCount);
-                Xml::XmlNode<char>* xmlItem = xmlCurrent->FirstNode(itemName.c_str(), itemName.size());
 
-                size_t size = Cpl::ParamVector<T>::Size();
-                for (size_t i = 0; i < itemCount; ++i)
-                {
-                    Unknown* paramChild = Cpl::ParamVector<T>::ChildBeg(i);
-                    const Unknown* paramChildEnd = Cpl::ParamVector<T>::ChildBeg(i + 1);
-                    for (; paramChild < paramChildEnd; paramChild = paramChild->End())
-                    {
-                        if (!paramChild->LoadNodeXml(xmlItem))
-                            return true;
-                    }
-                    xmlItem = xmlItem->NextSibling(itemName.c_str(), itemName.size());
-                }
+                int count = 0;
+                Cpl::ToVal(Xml::ExpandedValue(countNode), count);
+                if (count != itemCount)
+                    return false;
             }
+            else if (itemCount != childrenCount)
+                return false;
+            size_t size = Cpl::ParamVector<T>::Size();
+            Cpl::ParamVector<T>::Resize(itemCount);
+            std::vector<Xml::XmlNode<char>*> xmlItems(itemCount);
+            Xml::XmlNode<char>* xmlItem = xmlCurrent->FirstNode(itemName.c_str(), itemName.size());
+            for (size_t i = 0; i < itemCount; ++i)
+            {
+                xmlItems[i] = xmlItem;
+                xmlItem = xmlItem->NextSibling(itemName.c_str(), itemName.size());
+            }
+            Cpl::ParamVector<T>::LoadItems(xmlItems, size);
             return true;
         }
 
         void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(this->Name().c_str()));
+            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, this->Name());
             
             Xml::XmlNode<char>* xmlCount = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(CountName().c_str()));
             xmlCount->Value(xmlDoc.AllocateString(Cpl::ToStr(Cpl::ParamVector<T>::Size()).c_str()));
@@ -115,68 +106,57 @@ namespace Cpl
     protected:
         typedef Cpl::Param<int> Unknown;
 
-        ParamMapV2(const String& name)
+        ParamMapV2(const char* name)
             : ParamMap<K, T>(name)
         {
         }
 
         CPL_INLINE String CountName() const { return "count"; }
 
-        bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
+        bool LoadCurrentXml(Xml::XmlNode<char>* xmlCurrent) override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlParent->FirstNode(this->Name().c_str());
-            if (xmlCurrent)
+            auto countName = CountName();
+            auto itemName = Cpl::ParamMap<K, T>::ItemName();
+            size_t itemCount = Xml::CountChildren(xmlCurrent, itemName.c_str(), itemName.size());
+            size_t childrenCount = Xml::CountChildren(xmlCurrent);
+
+            auto* countNode = xmlCurrent->FirstNode(countName.c_str(), countName.size());
+            // 0 or 1 'count' node allowed
+            if (countNode)
             {
-                auto countName = CountName();
-                auto itemName = Cpl::ParamMap<K, T>::ItemName();
-                size_t itemCount = Xml::CountChildren(xmlCurrent, itemName.c_str(), itemName.size());
-                size_t childrenCount = Xml::CountChildren(xmlCurrent);
-
-                auto* countNode = xmlCurrent->FirstNode(countName.c_str(), countName.size());
-                // 0 or 1 'count' node allowed
-                if (countNode)
-                {
-                    if (itemCount != childrenCount - 1)
-                        return false;
+                if (itemCount != childrenCount - 1)
+                    return false;
 
-                    int count = 0;
-                    Cpl::ToVal(countNode->Value(), count);
-                    if (count != itemCount)
-                        return false;
-                }
-                else if (itemCount != childrenCount)
+                int count = 0;
+                Cpl::ToVal(Xml::ExpandedValue(countNode), count);
+                if (count != itemCount)
                     return false;
+            }
+            else if (itemCount != childrenCount)
+                return false;
 
-                Xml::XmlNode<char>* xmlItem = xmlCurrent->FirstNode(itemName.c_str(), itemName.size());
-                for (size_t i = 0; i < itemCount; ++i)
+            std::vector<K> keys;
+            std::vector<Xml::XmlNode<char>*> xmlValues;
+            Xml::XmlNode<char>* xmlItem = xmlCurrent->FirstNode(itemName.c_str(), itemName.size());
+            for (size_t i = 0; i < itemCount; ++i)
+            {
+                Xml::XmlNode<char>* xmlKey = xmlItem->FirstNode(Cpl::ParamMap<K, T>::KeyName().c_str());
+                if (xmlKey)
                 {
-                    Xml::XmlNode<char>* xmlKey = xmlItem->FirstNode(Cpl::ParamMap<K, T>::KeyName().c_str());
-                    if (xmlKey)
-                    {
-                        K key;
-                        Cpl::ToVal(xmlKey->Value(), key);
-                        T& value = this->_value[key];
-                        Xml::XmlNode<char>* xmlValue = xmlItem->FirstNode(Cpl::ParamMap<K, T>::ValueName().c_str());
-                        if (xmlValue)
-                        {
-                            Unknown* paramChild = Cpl::ParamMap<K, T>::ChildBeg(value);
-                            Unknown* paramChildEnd = Cpl::ParamMap<K, T>::ChildEnd(value);
-                            for (; paramChild < paramChildEnd; paramChild = paramChild->End())
-                            {
-                                if (!paramChild->LoadNodeXml(xmlValue))
-                                    return true;
-                            }
-                        }
-                    }
-                    xmlItem = xmlItem->NextSibling(itemName.c_str(), itemName.size());
+                    K key;
+                    Cpl::ToVal(Xml::ExpandedValue(xmlKey), key);
+                    keys.push_back(key);
+                    xmlValues.push_back(xmlItem->FirstNode(Cpl::ParamMap<K, T>::ValueName().c_str()));
                 }
+                xmlItem = xmlItem->NextSibling(itemName.c_str(), itemName.size());
             }
+            Cpl::ParamMap<K, T>::LoadItems(keys, xmlValues);
             return true;
         }
 
         void SaveNodeXml(Xml::XmlDocument<char>& xmlDoc, Xml::XmlNode<char>* xmlParent, bool full) const override
         {
-            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(this->Name().c_str()));
+            Xml::XmlNode<char>* xmlCurrent = xmlDoc.AllocateNode(Xml::NodeElement, this->Name());
             Xml::XmlNode<char>* xmlCount = xmlDoc.AllocateNode(Xml::NodeElement, xmlDoc.AllocateString(CountName().c_str()));
             xmlCount->Value(xmlDoc.AllocateString(Cpl::ToStr(this->_value.size()).c_str()));
             xmlCurrent->AppendNode(xmlCount);
@@ -0,0 +1,366 @@
+/*
+* Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "Cpl/Param.h"
+#include "Cpl/Time.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace Cpl
+{
+    /*
+    * Watches a parameter file (T is a type declared by CPL_PARAM_HOLDER) and reloads it in a background thread.
+    * On Linux the directory of the file is watched with inotify, otherwise (or if inotify is unavailable)
+    * size, modification and change times of the file are polled. While the stamp is too recent to be trusted
+    * (a same-size rewrite may fit in one timestamp tick) the file is hashed on each poll. Changes are debounced, the file is parsed again
+    * only if the hash of its content differs from the last loaded one. A file that fails to parse is retried with growing
+    * delay (up to the polling interval) until it is loaded. The callback is called from the thread calling Start() for the
+    * initial load, from the thread calling Check() and from the watcher thread for reloads, but never concurrently and
+    * without internal locks held: if a reload happens while the callback runs (e.g. it calls Check() itself), the new
+    * parameters are passed by the thread running the callback after it returns. The callback must not call Stop().
+    */
+    template<class T> class ParamWatcher
+    {
+    public:
+        typedef std::shared_ptr<T> Pointer;
+
+        typedef void(*Callback)(const Pointer& param, void* userData);
+
+        ParamWatcher(const String& path, Callback callback, void* userData, ParamFormat format = ParamFormatByExt)
+            : _path(path)
+            , _format(format)
+            , _callback(callback)
+            , _userData(userData)
+            , _debounce(0)
+            , _interval(0)
+            , _hash(0)
+            , _hashed(false)
+            , _delivering(false)
+            , _reloads(0)
+            , _stop(false)
+            , _inotify(-1)
+            , _watch(-1)
+        {
+        }
+
+        ~ParamWatcher()
+        {
+            Stop();
+        }
+
+        bool Start(double debounce = 0.050, double interval = 0.500, bool polling = false)
+        {
+            if (_thread.joinable() || !DetectParamFormat(_path, _format))
+                return false;
+            _debounce = debounce;
+            _interval = interval;
+            _stop = false;
+#ifdef __linux__
+            if (!polling)
+            {
+                String name = FileNameByPath(_path);
+                String dir = name == _path ? String(".") : DirectoryByPath(_path);
+                _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                if (_inotify >= 0)
+                    _watch = inotify_add_watch(_inotify, dir.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                if (_watch < 0)
+                    CloseInotify();
+            }
+#endif
+            Stamp stamp = GetStamp();
+            Check();
+            _thread = std::thread(&ParamWatcher::Run, this, stamp);
+            return true;
+        }
+
+        void Stop()
+        {
+            if (!_thread.joinable())
+                return;
+            {
+                std::lock_guard<std::mutex> lock(_wait);
+                _stop = true;
+#ifdef __linux__
+                if (_watch >= 0)
+                    inotify_rm_watch(_inotify, _watch);
+#endif
+            }
+            _wake.notify_all();
+            _thread.join();
+            CloseInotify();
+        }
+
+        bool Check()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            String data;
+            if (!ReadData(data))
+                return false;
+            uint64_t hash = Hash(data);
+            if (_hashed && hash == _hash)
+                return false;
+            Pointer param = std::make_shared<T>();
+            if (!param->Load(data.c_str(), data.size(), _format))
+                return false;
+            _hash = hash;
+            _hashed = true;
+            _reloads++;
+            if (!_callback)
+                return true;
+            _next = param;
+            if (_delivering)
+                return true;
+            _delivering = true;
+            while (_next)
+            {
+                Pointer next;
+                next.swap(_next);
+                lock.unlock();
+                _callback(next, _userData);
+                lock.lock();
+            }
+            _delivering = false;
+            return true;
+        }
+
+        CPL_INLINE const String& Path() const
+        {
+            return _path;
+        }
+
+        CPL_INLINE bool Inotify() const
+        {
+            return _inotify >= 0;
+        }
+
+        CPL_INLINE size_t Reloads() const
+        {
+            return _reloads.load();
+        }
+
+    private:
+        struct Stamp
+        {
+            int64_t size, modified, changed, taken;
+
+            Stamp(int64_t s = -1, int64_t m = -1, int64_t c = -1)
+                : size(s)
+                , modified(m)
+                , changed(c)
+                , taken(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
+            {
+            }
+
+            bool operator != (const Stamp& other) const
+            {
+                return size != other.size || modified != other.modified || changed != other.changed;
+            }
+
+            bool Racy() const
+            {
+                return size >= 0 && std::max(modified, changed) + Tick > taken;
+            }
+
+            static const int64_t Tick = 2000000000;
+        };
+
+        String _path;
+        ParamFormat _format;
+        Callback _callback;
+        void* _userData;
+        double _debounce, _interval;
+        uint64_t _hash;
+        bool _hashed, _delivering;
+        Pointer _next;
+        std::atomic<size_t> _reloads;
+        std::mutex _mutex, _wait;
+        std::condition_variable _wake;
+        bool _stop;
+        std::atomic<int> _inotify;
+        int _watch;
+        std::thread _thread;
+
+        void Run(Stamp stamp)
+        {
+            bool pending = false;
+            double deadline = 0, retry = _debounce;
+            while (true)
+            {
+                double timeout = pending ? std::max(deadline - Time(), 0.0) : _interval;
+                bool changed = false;
+                if (Inotify())
+                    changed = WaitInotify(timeout);
+                else
+                {
+                    std::unique_lock<std::mutex> lock(_wait);
+                    _wake.wait_for(lock, std::chrono::duration<double>(timeout), [this]() { return _stop; });
+                }
+                if (Stopped())
+                    break;
+                if (!Inotify())
+                {
+                    Stamp current = GetStamp();
+                    changed = current != stamp || (!pending && stamp.Racy() && Modified());
+                    stamp = current;
+                }
+                if (changed)
+                {
+                    pending = true;
+                    deadline = Time() + _debounce;
+                }
+                else if (pending && Time() >= deadline)
+                {
+                    pending = false;
+                    if (Check() || !Modified())
+                        retry = _debounce;
+                    else
+                    {
+                        pending = true;
+                        deadline = Time() + retry;
+                        retry = std::min(retry * 2, std::max(_interval, _debounce));
+                    }
+                }
+            }
+        }
+
+        bool Modified()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            String data;
+            return ReadData(data) && (!_hashed || Hash(data) != _hash);
+        }
+
+        bool Stopped()
+        {
+            std::lock_guard<std::mutex> lock(_wait);
+            return _stop;
+        }
+
+        bool WaitInotify(double timeout)
+        {
+#ifdef __linux__
+            pollfd fd = { _inotify, POLLIN, 0 };
+            if (poll(&fd, 1, int(timeout * 1000.0 + 0.5)) <= 0)
+                return false;
+            String name = FileNameByPath(_path);
+            bool changed = false, ignored = false;
+            char buffer[4096];
+            ssize_t size;
+            while ((size = read(_inotify, buffer, sizeof(buffer))) > 0)
+            {
+                for (const char* ptr = buffer; ptr < buffer + size;)
+                {
+                    const inotify_event* event = (const inotify_event*)ptr;
+                    if (event->mask & IN_Q_OVERFLOW)
+                        changed = true;
+                    if (event->mask & IN_IGNORED)
+                        ignored = true;
+                    if (event->len && name == event->name)
+                        changed = true;
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+            if (ignored)
+            {
+                std::lock_guard<std::mutex> lock(_wait);
+                if (!_stop)
+                {
+                    CPL_LOG_SS(Warning, "Directory of '" << _path << "' is not watched any more, switch to polling.");
+                    CloseInotify();
+                    changed = true;
+                }
+            }
+            return changed;
+#else
+            return false;
+#endif
+        }
+
+        void CloseInotify()
+        {
+#ifdef __linux__
+            if (_inotify >= 0)
+                close(_inotify);
+#endif
+            _inotify = -1;
+            _watch = -1;
+        }
+
+        Stamp GetStamp() const
+        {
+#if defined(_MSC_VER)
+            struct _stat64 buf;
+            if (_stat64(_path.c_str(), &buf) != 0)
+                return Stamp();
+            return Stamp(int64_t(buf.st_size), int64_t(buf.st_mtime) * 1000000000, int64_t(buf.st_ctime) * 1000000000);
+#else
+            struct stat buf;
+            if (stat(_path.c_str(), &buf) != 0)
+                return Stamp();
+#ifdef __linux__
+            return Stamp(int64_t(buf.st_size), int64_t(buf.st_mtim.tv_sec) * 1000000000 + buf.st_mtim.tv_nsec,
+                int64_t(buf.st_ctim.tv_sec) * 1000000000 + buf.st_ctim.tv_nsec);
+#else
+            return Stamp(int64_t(buf.st_size), int64_t(buf.st_mtime) * 1000000000, int64_t(buf.st_ctime) * 1000000000);
+#endif
+#endif
+        }
+
+        bool ReadData(String& data) const
+        {
+            std::ifstream ifs(_path.c_str(), std::ifstream::binary);
+            if (!ifs.is_open())
+                return false;
+            data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            return !ifs.bad();
+        }
+
+        static uint64_t Hash(const String& data)
+        {
+            uint64_t hash = 14695981039346656037ULL;
+            for (size_t i = 0; i < data.size(); ++i)
+                hash = (hash ^ uint64_t((uint8_t)data[i])) * 1099511628211ULL;
+            return hash;
+        }
+    };
+}
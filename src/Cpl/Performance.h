@@ -28,11 +28,13 @@
 #include "Cpl/Time.h"
 #include "Cpl/Utils.h"
 #include "Cpl/String.h"
+#include "Cpl/Log.h"
 
 #include <mutex>
 #include <map>
 #include <thread>
 #include <memory>
+#include <new>
 
 #if defined(_MSC_VER)
 #ifndef NOMINMAX
@@ -127,13 +129,32 @@ namespace Cpl
 
     //-----------------------------------------------------------------------------------------------------
 
+    struct PerformanceAllocation
+    {
+        int64_t count, size;
+    };
+
+#if defined(CPL_PERF_ALLOC_ENABLE)
+    CPL_INLINE PerformanceAllocation& ThreadAllocation()
+    {
+        static thread_local PerformanceAllocation allocation = { 0, 0 };
+        return allocation;
+    }
+#endif
+
+    //-----------------------------------------------------------------------------------------------------
+
     class PerformanceMeasurer
     {
         String	_name;
         int64_t _start, _current, _total, _min, _max;
         int64_t _count, _flop;
+        int64_t _slow, _warned, _suppressed;
         bool _entered, _paused;
         PerformanceHistogram _histogram;
+#if defined(CPL_PERF_ALLOC_ENABLE)
+        PerformanceAllocation _allocStart, _allocCurrent, _allocTotal;
+#endif
 
     public:
         CPL_INLINE PerformanceMeasurer(const String& name, int64_t flop = 0, uint32_t hist = 0)
@@ -145,9 +166,17 @@ namespace Cpl
             , _total(0)
             , _min(std::numeric_limits<int64_t>::max())
             , _max(std::numeric_limits<int64_t>::min())
+            , _slow(std::numeric_limits<int64_t>::max())
+            , _warned(0)
+            , _suppressed(0)
             , _entered(false)
             , _paused(false)
             , _histogram(hist)
+#if defined(CPL_PERF_ALLOC_ENABLE)
+            , _allocStart({ 0, 0 })
+            , _allocCurrent({ 0, 0 })
+            , _allocTotal({ 0, 0 })
+#endif
         {
         }
 
@@ -160,9 +189,17 @@ namespace Cpl
             , _total(pm._total)
             , _min(pm._min)
             , _max(pm._max)
+            , _slow(pm._slow)
+            , _warned(pm._warned)
+            , _suppressed(pm._suppressed)
             , _entered(pm._entered)
             , _paused(pm._paused)
             , _histogram(pm._histogram)
+#if defined(CPL_PERF_ALLOC_ENABLE)
+            , _allocStart(pm._allocStart)
+            , _allocCurrent(pm._allocCurrent)
+            , _allocTotal(pm._allocTotal)
+#endif
         {
         }
 
@@ -172,6 +209,9 @@ namespace Cpl
             {
                 _entered = true;
                 _paused = false;
+#if defined(CPL_PERF_ALLOC_ENABLE)
+                _allocStart = ThreadAllocation();
+#endif
                 _start = TimeCounter();
             }
         }
@@ -184,9 +224,16 @@ namespace Cpl
                 {
                     _entered = false;
                     _current += TimeCounter() - _start;
+#if defined(CPL_PERF_ALLOC_ENABLE)
+                    const PerformanceAllocation& allocation = ThreadAllocation();
+                    _allocCurrent.count += allocation.count - _allocStart.count;
+                    _allocCurrent.size += allocation.size - _allocStart.size;
+#endif
                 }
                 if (!pause)
                 {
+                    if (_current > _slow)
+                        WarnSlow();
                     _total += _current;
                     _min = std::min(_min, _current);
                     _max = std::max(_max, _current);
@@ -194,11 +241,26 @@ namespace Cpl
                     if (_histogram.Enable())
                         _histogram.Add(_current);
                     _current = 0;
+#if defined(CPL_PERF_ALLOC_ENABLE)
+                    _allocTotal.count += _allocCurrent.count;
+                    _allocTotal.size += _allocCurrent.size;
+                    _allocCurrent = { 0, 0 };
+#endif
                 }
                 _paused = pause;
             }
         }
 
+        CPL_INLINE void SetSlow(double ms)
+        {
+            _slow = ms > 0 ? int64_t(ms * double(TimeFrequency()) / 1000.0) : std::numeric_limits<int64_t>::max();
+        }
+
+        CPL_INLINE double Slow() const
+        {
+            return _slow == std::numeric_limits<int64_t>::max() ? 0.0 : Miliseconds(_slow);
+        }
+
         CPL_INLINE void Merge(const PerformanceMeasurer& other)
         {
             assert(_name == other._name);
@@ -208,6 +270,10 @@ namespace Cpl
             _max = std::max(_max, other._max);
             if (_histogram.Enable())
                 _histogram.Merge(other._histogram);
+#if defined(CPL_PERF_ALLOC_ENABLE)
+            _allocTotal.count += other._allocTotal.count;
+            _allocTotal.size += other._allocTotal.size;
+#endif
         }
 
         CPL_INLINE double Average() const
@@ -245,6 +311,24 @@ namespace Cpl
             return (size_t)_count;
         }
 
+        CPL_INLINE double Allocations() const
+        {
+#if defined(CPL_PERF_ALLOC_ENABLE)
+            return _count ? double(_allocTotal.count) / double(_count) : 0.0;
+#else
+            return 0.0;
+#endif
+        }
+
+        CPL_INLINE double AllocatedBytes() const
+        {
+#if defined(CPL_PERF_ALLOC_ENABLE)
+            return _count ? double(_allocTotal.size) / double(_count) : 0.0;
+#else
+            return 0.0;
+#endif
+        }
+
         CPL_INLINE String Name() const
         {
             return _name;
@@ -262,11 +346,31 @@ namespace Cpl
                 ss << "; q90 = " << Cpl::ToStr(Quantile(90.0), 3);
                 ss << "; q99 = " << Cpl::ToStr(Quantile(99.0), 3);
             }
+#if defined(CPL_PERF_ALLOC_ENABLE)
+            ss << "; allocs = " << Cpl::ToStr(Allocations(), 1);
+            ss << "; bytes = " << Cpl::ToStr(AllocatedBytes(), 0);
+#endif
             ss << "}";
             if (_flop)
                 ss << " " << Cpl::ToStr(GFlops(), 1) << " GFlops";
             return ss.str();
         }
+
+    private:
+        void WarnSlow()
+        {
+            int64_t current = TimeCounter();
+            if (_warned && current - _warned < TimeFrequency())
+            {
+                _suppressed++;
+                return;
+            }
+            CPL_LOG_SS(Warning, "Slow call of '" << _name << "': " << Cpl::ToStr(Miliseconds(_current), 3) << " ms (limit is "
+                << Cpl::ToStr(Miliseconds(_slow), 3) << " ms) in thread " << std::this_thread::get_id()
+                << (_suppressed ? ", " + Cpl::ToStr(_suppressed) + " similar warnings were suppressed" : String()) << ".");
+            _warned = current;
+            _suppressed = 0;
+        }
     };
 
     //-----------------------------------------------------------------------------------------------------
@@ -276,9 +380,11 @@ namespace Cpl
         PerformanceMeasurer* _pm;
 
     public:
-        inline PerformanceHolder(PerformanceMeasurer* pm, bool enter = true)
+        inline PerformanceHolder(PerformanceMeasurer* pm, bool enter = true, double slow = 0)
             : _pm(pm)
         {
+            if (_pm && slow > 0)
+                _pm->SetSlow(slow);
             if (_pm && enter)
                 _pm->Enter();
         }
@@ -420,10 +526,12 @@ namespace Cpl
 #define CPL_PERF_FUNCFH(flop, hist) Cpl::PerformanceHolder CPL_CAT(__ph, __LINE__)(Cpl::PerformanceStorage::Global().Get(CPL_FUNCTION, (int64_t)(flop), (hist)))
 #define CPL_PERF_FUNCF(flop) CPL_PERF_FUNCFH(flop, 0)
 #define CPL_PERF_FUNC() CPL_PERF_FUNCFH(0, 0)
+#define CPL_PERF_FUNC_SLOW(ms) Cpl::PerformanceHolder CPL_CAT(__ph, __LINE__)(Cpl::PerformanceStorage::Global().Get(CPL_FUNCTION), true, (ms))
 
 #define CPL_PERF_BEGFH(desc, flop, hist) Cpl::PerformanceHolder CPL_CAT(__ph, __LINE__)(Cpl::PerformanceStorage::Global().Get(CPL_FUNCTION, desc, (int64_t)(flop), (hist)))
 #define CPL_PERF_BEGF(desc, flop) CPL_PERF_BEGFH(desc, flop, 0)
 #define CPL_PERF_BEG(desc) CPL_PERF_BEGFH(desc, 0, 0)
+#define CPL_PERF_BEG_SLOW(desc, ms) Cpl::PerformanceHolder CPL_CAT(__ph, __LINE__)(Cpl::PerformanceStorage::Global().Get(CPL_FUNCTION, desc), true, (ms))
 
 #define CPL_PERF_IFFH(cond, desc, flop, hist) Cpl::PerformanceHolder CPL_CAT(__ph, __LINE__)((cond) ? Cpl::PerformanceStorage::Global().Get(CPL_FUNCTION, desc, (int64_t)(flop), (hist)) : NULL)
 #define CPL_PERF_IFF(cond, desc, flop) CPL_PERF_IFFH(cond, desc, flop, 0)
@@ -438,15 +546,167 @@ namespace Cpl
 #define CPL_PERF_START(name) name.Enter(); 
 #define CPL_PERF_PAUSE(name) name.Leave(true);
 
+#if defined(CPL_PERF_ALLOC_ENABLE) && defined(CPL_IMPLEMENT)
+namespace Cpl
+{
+    namespace Detail
+    {
+        /*
+        * Allocation and release are not inlined into replaced operators new/delete,
+        * so the compiler doesn't pair malloc/free with new/delete expressions of user code.
+        */
+        CPL_NOINLINE void* PerformanceAllocate(size_t size, size_t align)
+        {
+            Cpl::PerformanceAllocation& allocation = Cpl::ThreadAllocation();
+            allocation.count++;
+            allocation.size += size;
+            size = size ? size : 1;
+            if (align <= sizeof(void*))
+                return malloc(size);
+#if defined(_MSC_VER)
+            return _aligned_malloc(size, align);
+#else
+            void* ptr = NULL;
+            return posix_memalign(&ptr, align, size) == 0 ? ptr : NULL;
+#endif
+        }
+
+        CPL_NOINLINE void PerformanceFree(void* ptr, size_t align)
+        {
+            if (align <= sizeof(void*))
+                free(ptr);
+            else
+            {
+#if defined(_MSC_VER)
+                _aligned_free(ptr);
+#else
+                free(ptr);
+#endif
+            }
+        }
+    }
+}
+
+void* operator new(size_t size)
+{
+    void* ptr = Cpl::Detail::PerformanceAllocate(size, 0);
+    if (ptr == NULL)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return Cpl::Detail::PerformanceAllocate(size, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return Cpl::Detail::PerformanceAllocate(size, 0);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, 0);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, 0);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, 0);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, 0);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, 0);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, 0);
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(size_t size, std::align_val_t align)
+{
+    void* ptr = Cpl::Detail::PerformanceAllocate(size, size_t(align));
+    if (ptr == NULL)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t align)
+{
+    return operator new(size, align);
+}
+
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return Cpl::Detail::PerformanceAllocate(size, size_t(align));
+}
+
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return Cpl::Detail::PerformanceAllocate(size, size_t(align));
+}
+
+void operator delete(void* ptr, std::align_val_t align) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, size_t(align));
+}
+
+void operator delete[](void* ptr, std::align_val_t align) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, size_t(align));
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t align) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, size_t(align));
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t align) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, size_t(align));
+}
+
+void operator delete(void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, size_t(align));
+}
+
+void operator delete[](void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    Cpl::Detail::PerformanceFree(ptr, size_t(align));
+}
+#endif
+#endif
+
 #else
 
 #define CPL_PERF_FUNCFH(flop, hist)
 #define CPL_PERF_FUNCF(flop)
 #define CPL_PERF_FUNC()
+#define CPL_PERF_FUNC_SLOW(ms)
 
 #define CPL_PERF_BEGFH(desc, flop, hist)
 #define CPL_PERF_BEGF(desc, flop)
 #define CPL_PERF_BEG(desc)
+#define CPL_PERF_BEG_SLOW(desc, ms)
 
 #define CPL_PERF_IFFH(cond, desc, flop, hist)
 #define CPL_PERF_IFF(cond, desc, flop)
@@ -59,16 +59,21 @@ namespace Cpl
         typedef Cpl::ParamLimited<T> Base;
         typedef Cpl::Param<int> Unknown;
 
-        ParamProp(const String& name)
+        ParamProp(const char* name)
             : Base(name)
         {
         }
 
+        bool KeyedByName() const override
+        {
+            return false;
+        }
+
         bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
         {
             Xml::XmlNode<char>* xmlValue = xmlParent->FirstNode("value");
             if(xmlValue)
-                Cpl::ToVal(xmlValue->Value(), this->_value);
+                Cpl::ToVal(Xml::ExpandedValue(xmlValue), this->_value);
             return true;
         }
 
@@ -136,19 +141,24 @@ namespace Cpl
 
         Map _map;
 
-        ParamStorage(const String& name)
+        ParamStorage(const char* name)
             : Base(name)
         {
             for (Unknown* group = this->ChildBeg(); group < this->End(); group = group->End())
             {
                 for (Unknown* prop = ((UnknownGroup*)group)->ChildBeg(); prop < group->End(); prop = prop->End())
                 {
-                    String name = group->Name() + "." + prop->Name();
+                    String name = String(group->Name()) + "." + prop->Name();
                     _map[name] = (UnknownProp*)prop;
                 }
             }
         }
 
+        bool KeyedByName() const override
+        {
+            return false;
+        }
+
         bool LoadNodeXml(Xml::XmlNode<char>* xmlParent) override
         {
             Xml::XmlNode<char>* xmlStorage = xmlParent->FirstNode("storage");
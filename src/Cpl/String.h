@@ -30,9 +30,13 @@
 
 #include <array>
 #include <cctype>
+#include <cerrno>
 #include <cmath>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <type_traits>
 
 #if _WIN32
 
@@ -181,23 +185,110 @@ namespace Cpl
 
     //-----------------------------------------------------------------------------------
 
-    template <class T> CPL_INLINE T ToVal(const String& str)
+    namespace Detail
     {
-        std::stringstream ss(str);
-        T t;
-        ss >> t;
-        return t;
+        template<class T> CPL_INLINE bool StreamToVal(const String& string, T& value)
+        {
+            std::stringstream ss(string);
+            ss >> value;
+            return !ss.fail();
+        }
+
+        CPL_INLINE bool EqualNoCase(const String& string, const char* lower)
+        {
+            size_t i = 0;
+            for (; i < string.size() && lower[i]; ++i)
+                if (::tolower((unsigned char)string[i]) != lower[i])
+                    return false;
+            return i == string.size() && lower[i] == 0;
+        }
+
+        CPL_INLINE const char* SkipSpaces(const char* str)
+        {
+            while (::isspace((unsigned char)*str))
+                ++str;
+            return str;
+        }
+
+        CPL_INLINE float StrTo(const char* str, char** end, float) { return ::strtof(str, end); }
+        CPL_INLINE double StrTo(const char* str, char** end, double) { return ::strtod(str, end); }
+        CPL_INLINE long double StrTo(const char* str, char** end, long double) { return ::strtold(str, end); }
+
+        // Uses strtoll/strtoull/strtod for the common well-formed inputs and falls back to std::stringstream 
+        // for everything else (overflow, hexadecimal, inf/nan, dangling exponent), so results do not change.
+        template<class T, class Enable = void> struct FromStr
+        {
+            static CPL_INLINE bool Get(const String& string, T& value)
+            {
+                return StreamToVal(string, value);
+            }
+        };
+
+        template<class T> struct FromStr<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value && (sizeof(T) > 1)>::type>
+        {
+            static CPL_INLINE bool Get(const String& string, T& value)
+            {
+                const char* str = string.c_str();
+                char* end;
+                errno = 0;
+                long long val = ::strtoll(str, &end, 10);
+                if (end == str || errno == ERANGE || val < (long long)std::numeric_limits<T>::min() || val > (long long)std::numeric_limits<T>::max())
+                    return StreamToVal(string, value);
+                value = T(val);
+                return true;
+            }
+        };
+
+        template<class T> struct FromStr<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && (sizeof(T) > 1)>::type>
+        {
+            static CPL_INLINE bool Get(const String& string, T& value)
+            {
+                const char* str = SkipSpaces(string.c_str());
+                char* end;
+                errno = 0;
+                unsigned long long val = *str == '-' ? 0 : ::strtoull(str, &end, 10);
+                if (*str == '-' || end == str || errno == ERANGE || val > (unsigned long long)std::numeric_limits<T>::max())
+                    return StreamToVal(string, value);
+                value = T(val);
+                return true;
+            }
+        };
+
+        template<class T> struct FromStr<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+        {
+            static CPL_INLINE bool Get(const String& string, T& value)
+            {
+                const char* str = SkipSpaces(string.c_str()), * digits = str + (*str == '-' || *str == '+');
+                if (!(::isdigit((unsigned char)*digits) || (*digits == '.' && ::isdigit((unsigned char)digits[1]))) ||
+                    (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')))
+                    return StreamToVal(string, value);
+                char* end;
+                errno = 0;
+                T val = StrTo(str, &end, T());
+                if (errno == ERANGE || ::isalpha((unsigned char)*end) || *end == '.')
+                    return StreamToVal(string, value);
+                value = val;
+                return true;
+            }
+        };
     }
 
     //-----------------------------------------------------------------------------------
 
     template<class T> CPL_INLINE void ToVal(const String& string, T& value)
     {
-        std::stringstream ss(string);
-        if(string != "" || string != " ")
-            ss >> value;
+        Detail::FromStr<T>::Get(string, value);
+    }
+
+    template <class T> CPL_INLINE T ToVal(const String& str)
+    {
+        T t;
+        ToVal<T>(str, t);
+        return t;
     }
 
+    //-----------------------------------------------------------------------------------
+
     template<> CPL_INLINE void ToVal<String>(const String& string, String& value)
     {
         if (string != "")
@@ -211,11 +302,10 @@ namespace Cpl
 
     template<> CPL_INLINE void ToVal<bool>(const String& string, bool& value)
     {
-        std::string lower = string;
-        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-        if (lower == "0" || lower == "false" || lower == "no" || lower == "off")
+        using Detail::EqualNoCase;
+        if (string == "0" || EqualNoCase(string, "false") || EqualNoCase(string, "no") || EqualNoCase(string, "off"))
             value = false;
-        else if (lower == "1" || lower == "true" || lower == "yes" || lower == "on")
+        else if (string == "1" || EqualNoCase(string, "true") || EqualNoCase(string, "yes") || EqualNoCase(string, "on"))
             value = true;
         else
             assert(0);
@@ -240,6 +330,79 @@ namespace Cpl
 
     //-----------------------------------------------------------------------------------
 
+    namespace Detail
+    {
+        template<class T, class Enable = void> struct TryFromStr
+        {
+            static CPL_INLINE bool Get(const String& string, T& value)
+            {
+                ToVal(string, value);
+                return true;
+            }
+        };
+
+        template<class T> struct TryFromStr<T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && (sizeof(T) > 1)>::type>
+        {
+            static CPL_INLINE bool Get(const String& string, T& value)
+            {
+                if (std::is_unsigned<T>::value && *SkipSpaces(string.c_str()) == '-')
+                    return false;
+                std::stringstream ss(string);
+                T val;
+                ss >> val;
+                if (ss.fail() || !(ss >> std::ws).eof())
+                    return false;
+                value = val;
+                return true;
+            }
+        };
+    }
+
+    /*
+    * Checked version of ToVal: returns false and leaves the value unchanged if the whole string is not a valid value.
+    * Numbers, bool, String and vectors of them are validated, other types are converted with ToVal.
+    */
+    template<class T> CPL_INLINE bool TryToVal(const String& string, T& value)
+    {
+        return Detail::TryFromStr<T>::Get(string, value);
+    }
+
+    template<> CPL_INLINE bool TryToVal<String>(const String& string, String& value)
+    {
+        value = string;
+        return true;
+    }
+
+    template<> CPL_INLINE bool TryToVal<bool>(const String& string, bool& value)
+    {
+        using Detail::EqualNoCase;
+        if (string == "0" || EqualNoCase(string, "false") || EqualNoCase(string, "no") || EqualNoCase(string, "off"))
+            value = false;
+        else if (string == "1" || EqualNoCase(string, "true") || EqualNoCase(string, "yes") || EqualNoCase(string, "on"))
+            value = true;
+        else
+            return false;
+        return true;
+    }
+
+    template<class T> CPL_INLINE bool TryToVal(const String& string, std::vector<T>& values)
+    {
+        std::stringstream ss(string);
+        std::vector<T> result;
+        String item;
+        while (ss >> item)
+        {
+            T value;
+            if (!TryToVal(item, value))
+                return false;
+            result.push_back(value);
+        }
+        values.swap(result);
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------
+
     CPL_INLINE String ToLowerCase(const String& src)
     {
         String dst(src);
@@ -533,4 +696,91 @@ namespace Cpl
 
         return std::array<String, 4> { prefix, login, password, path };
     }
+
+    //-----------------------------------------------------------------------------------
+
+    CPL_INLINE String ToBase64(const void* data, size_t size)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        const uint8_t* src = (const uint8_t*)data;
+        String dst((size + 2) / 3 * 4, '=');
+        char* out = &dst[0];
+        size_t i = 0;
+        for (; i + 3 <= size; i += 3, out += 4)
+        {
+            uint32_t triple = (uint32_t(src[i]) << 16) | (uint32_t(src[i + 1]) << 8) | uint32_t(src[i + 2]);
+            out[0] = alphabet[(triple >> 18) & 63];
+            out[1] = alphabet[(triple >> 12) & 63];
+            out[2] = alphabet[(triple >> 6) & 63];
+            out[3] = alphabet[triple & 63];
+        }
+        if (i < size)
+        {
+            uint32_t triple = (uint32_t(src[i]) << 16) | (i + 1 < size ? uint32_t(src[i + 1]) << 8 : 0);
+            out[0] = alphabet[(triple >> 18) & 63];
+            out[1] = alphabet[(triple >> 12) & 63];
+            if (i + 1 < size)
+                out[2] = alphabet[(triple >> 6) & 63];
+        }
+        return dst;
+    }
+
+    namespace Detail
+    {
+        struct Base64Table
+        {
+            enum { Invalid = 0xFF, Pad = 0xFE, Space = 0xFD };
+            uint8_t codes[256];
+
+            Base64Table()
+            {
+                memset(codes, Invalid, 256);
+                for (int i = 0; i < 64; ++i)
+                    codes[(uint8_t)"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[i]] = uint8_t(i);
+                codes['='] = Pad;
+                codes[' '] = codes['\t'] = codes['\r'] = codes['\n'] = Space;
+            }
+        };
+    }
+
+    // Decodes base64 text (whitespace is skipped) to 'dst' which must hold the decoded bytes (at most size / 4 * 3).
+    // Returns number of decoded bytes or -1 for invalid text.
+    CPL_INLINE ptrdiff_t FromBase64(const char* src, size_t size, void* dst)
+    {
+        typedef Detail::Base64Table Table;
+        static const Table table;
+        uint8_t* out = (uint8_t*)dst;
+        uint32_t quad = 0;
+        size_t count = 0, pad = 0;
+        for (const char* end = src + size; src < end; ++src)
+        {
+            uint8_t code = table.codes[(uint8_t)*src];
+            if (code == Table::Space)
+                continue;
+            if (code == Table::Invalid || (pad && code != Table::Pad))
+                return -1;
+            if (code == Table::Pad)
+            {
+                if (++pad > 2 || count < 2)
+                    return -1;
+                code = 0;
+            }
+            quad = (quad << 6) | code;
+            if (++count == 4)
+            {
+                *out++ = uint8_t(quad >> 16);
+                if (pad < 2)
+                    *out++ = uint8_t(quad >> 8);
+                if (pad < 1)
+                    *out++ = uint8_t(quad);
+                count = 0;
+                quad = 0;
+                if (pad)
+                    pad = 3;
+            }
+        }
+        if (count)
+            return -1;
+        return out - (uint8_t*)dst;
+    }
 }
@@ -27,12 +27,16 @@
 #pragma once
 
 #include "Cpl/Defs.h"
+#include "Cpl/OutputBuffer.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
 #include <iterator>
 #include <new>
 #include <exception>
+#include <memory>
+#include <thread>
 
 namespace Cpl
 {
@@ -40,6 +44,7 @@ namespace Cpl
     {
         const size_t STATIC_POOL_SIZE = 64 * 1024;
         const size_t DYNAMIC_POOL_SIZE = 64 * 1024;
+        const size_t PARALLEL_PART_SIZE = 256 * 1024;
         const size_t ALIGNMENT = sizeof(void*);
         
         class ParseError : public std::exception
@@ -69,6 +74,7 @@ namespace Cpl
         template<class Ch> class XmlNode;
         template<class Ch> class XmlAttribute;
         template<class Ch> class XmlDocument;
+        template<class Ch, int Flags> class XmlReader;
 
         enum NodeType
         {
@@ -94,10 +100,12 @@ namespace Cpl
         const int ParseValidateClosingTags = 0x200;
         const int ParseTrimWhitespace = 0x400;
         const int ParseNormalizeWhitespace = 0x800;
+        const int ParseInternNames = 0x1000;
         const int ParseDefault = 0;
         const int ParseNonDestructive = ParseNoStringTerminators | ParseNoEntityTranslation;
         const int ParseFasTest = ParseNonDestructive | ParseNoDataNodes;
         const int ParseFull = ParseDeclarationNode | ParseCommentNodes | ParseDocTypeNode | ParsePiNodes | ParseValidateClosingTags;
+        const int ParseValuesOnly = ParseNoDataNodes | ParseNoEntityTranslation;
 
         namespace Internal
         {
@@ -360,6 +368,7 @@ namespace Cpl
                 : _name(0)
                 , _value(0)
                 , _parent(0)
+                , _nameId(0)
             {
             }
 
@@ -373,6 +382,11 @@ namespace Cpl
                 return _name ? _nameSize : 0;
             }
 
+            size_t NameId() const
+            {
+                return _nameId;
+            }
+
             Ch * Value() const
             {
                 return _value ? _value : NullStr();
@@ -387,6 +401,7 @@ namespace Cpl
             {
                 _name = const_cast<Ch *>(name);
                 _nameSize = size;
+                _nameId = 0;
             }
 
             void Name(const Ch *name)
@@ -411,6 +426,8 @@ namespace Cpl
             }
 
         protected:
+            friend class XmlDocument<Ch>;
+
             static Ch * NullStr()
             {
                 static Ch zero = Ch('\0');
@@ -422,6 +439,7 @@ namespace Cpl
             size_t _nameSize;
             size_t _valueSize;
             XmlNode<Ch> * _parent;
+            size_t _nameId;
         };
 
         template<class Ch = char> class XmlAttribute : public XmlBase<Ch>
@@ -434,10 +452,10 @@ namespace Cpl
 
             XmlDocument<Ch> *document() const
             {
-                if (XmlNode<Ch> *node = this->parent())
+                if (XmlNode<Ch> *node = this->Parent())
                 {
-                    while (node->parent())
-                        node = node->parent();
+                    while (node->Parent())
+                        node = node->Parent();
                     return node->Type() == NodeDocument ? static_cast<XmlDocument<Ch> *>(node) : 0;
                 }
                 else
@@ -474,9 +492,19 @@ namespace Cpl
                     return this->_parent ? _nextAttribute : 0;
             }
 
+            XmlAttribute<Ch> *NextAttributeById(size_t id) const
+            {
+                if (id == 0 || this->_parent == 0)
+                    return 0;
+                for (XmlAttribute<Ch> *attribute = _nextAttribute; attribute; attribute = attribute->_nextAttribute)
+                    if (attribute->_nameId == id)
+                        return attribute;
+                return 0;
+            }
+
         private:
-            XmlAttribute<Ch> *_prevAttribute;
             XmlAttribute<Ch> *_nextAttribute;
+            XmlAttribute<Ch> *_prevAttribute;
         };
 
         template<class Ch = char>
@@ -485,12 +513,12 @@ namespace Cpl
         public:
             XmlNode(NodeType type)
                 : _type(type)
+                , _nextSibling(0)
                 , _firstNode(0)
                 , _lastNode(0)
-                , _prevSibling(0)
-                , _nextSibling(0)
-                , _lastAttribute(0)
                 , _firstAttribute(0)
+                , _lastAttribute(0)
+                , _prevSibling(0)
             {
             }
 
@@ -502,8 +530,8 @@ namespace Cpl
             XmlDocument<Ch> * Document() const
             {
                 XmlNode<Ch> *node = const_cast<XmlNode<Ch> *>(this);
-                while (node->parent())
-                    node = node->parent();
+                while (node->Parent())
+                    node = node->Parent();
                 return node->Type() == NodeDocument ? static_cast<XmlDocument<Ch> *>(node) : 0;
             }
 
@@ -522,6 +550,16 @@ namespace Cpl
                     return _firstNode;
             }
 
+            XmlNode<Ch> * FirstNodeById(size_t id) const
+            {
+                if (id == 0)
+                    return 0;
+                for (XmlNode<Ch> *child = _firstNode; child; child = child->_nextSibling)
+                    if (child->_nameId == id)
+                        return child;
+                return 0;
+            }
+
             XmlNode<Ch> * LastNode(const Ch *name = 0, size_t nameSize = 0, bool caseSensitive = true) const
             {
                 assert(_firstNode);
@@ -570,6 +608,17 @@ namespace Cpl
                     return _nextSibling;
             }
 
+            XmlNode<Ch> *NextSiblingById(size_t id) const
+            {
+                assert(this->_parent);
+                if (id == 0)
+                    return 0;
+                for (XmlNode<Ch> *sibling = _nextSibling; sibling; sibling = sibling->_nextSibling)
+                    if (sibling->_nameId == id)
+                        return sibling;
+                return 0;
+            }
+
             XmlAttribute<Ch> *FirstAttribute(const Ch *name = 0, size_t nameSize = 0, bool caseSensitive = true) const
             {
                 if (name)
@@ -585,6 +634,16 @@ namespace Cpl
                     return _firstAttribute;
             }
 
+            XmlAttribute<Ch> *FirstAttributeById(size_t id) const
+            {
+                if (id == 0)
+                    return 0;
+                for (XmlAttribute<Ch> *attribute = _firstAttribute; attribute; attribute = attribute->_nextAttribute)
+                    if (attribute->_nameId == id)
+                        return attribute;
+                return 0;
+            }
+
             XmlAttribute<Ch> * LastAttribute(const Ch *name = 0, size_t nameSize = 0, bool caseSensitive = true) const
             {
                 if (name)
@@ -817,12 +876,12 @@ namespace Cpl
             void operator =(const XmlNode &);
 
             NodeType _type;
+            XmlNode<Ch> *_nextSibling;
             XmlNode<Ch> *_firstNode; 
             XmlNode<Ch> *_lastNode;
             XmlAttribute<Ch> *_firstAttribute; 
             XmlAttribute<Ch> *_lastAttribute; 
             XmlNode<Ch> *_prevSibling; 
-            XmlNode<Ch> *_nextSibling;
         };
 
         template<class Ch = char> class XmlDocument : public XmlNode<Ch>, public MemoryPool<Ch>
@@ -839,6 +898,7 @@ namespace Cpl
                 const Ch * startPos = text;
                 this->RemoveAllNodes();
                 this->RemoveAllAttributes();
+                ClearNames();
                 ParseBom<Flags>(text);
                 while (length - size_t(text - startPos) && *text != 0)
                 {
@@ -854,14 +914,70 @@ namespace Cpl
                 }
             }
 
+            template<int Flags> void ParseParallel(Ch * text, size_t length, size_t threads = 0)
+            {
+                assert(text);
+                if (threads == 0)
+                    threads = std::thread::hardware_concurrency();
+                threads = std::max<size_t>(1, std::min(threads, length / PARALLEL_PART_SIZE));
+                const Ch * startPos = text;
+                this->RemoveAllNodes();
+                this->RemoveAllAttributes();
+                ClearNames();
+                ParseBom<Flags>(text);
+                while (length - size_t(text - startPos) && *text != 0)
+                {
+                    Skip<Whitespace, Flags>(text);
+                    if (*text == Ch('<'))
+                    {
+                        ++text;
+                        if (threads > 1 && *text != Ch('?') && *text != Ch('!'))
+                        {
+                            this->AppendNode(ParseElement<Flags>(text, threads));
+                            threads = 1;
+                        }
+                        else if (XmlNode<Ch> *node = ParseNode<Flags>(text))
+                            this->AppendNode(node);
+                    }
+                    else if (*text != 0)
+                        throw ParseError("expected <", text);
+                }
+            }
+
             void Clear()
             {
                 this->RemoveAllNodes();
                 this->RemoveAllAttributes();
                 MemoryPool<Ch>::Clear();
+                ClearNames();
+                _parts.clear();
+            }
+
+            size_t NameId(const Ch * name, size_t size = 0) const
+            {
+                if (_nameIndex.empty())
+                    return 0;
+                if (size == 0)
+                    size = Internal::Measure(name);
+                size_t hash = NameHash(name, size), mask = _nameIndex.size() - 1;
+                for (size_t i = hash & mask; _nameIndex[i]; i = (i + 1) & mask)
+                    if (Equal(_names[_nameIndex[i] - 1], name, size, hash))
+                        return _nameIndex[i];
+                return 0;
+            }
+
+            size_t NameCount() const
+            {
+                return _names.size();
+            }
+
+            static Ch * ExpandEntities(Ch * text)
+            {
+                return SkipAndExpandCharacterRefs<Unterminated, UnterminatedPure, ParseDefault>(text);
             }
 
         private:
+            template<class, int> friend class XmlReader;
 
             struct Whitespace
             {
@@ -1031,6 +1147,22 @@ namespace Cpl
                 }
             };
 
+            struct Unterminated
+            {
+                static unsigned char Test(Ch ch)
+                {
+                    return ch != Ch('\0');
+                }
+            };
+
+            struct UnterminatedPure
+            {
+                static unsigned char Test(Ch ch)
+                {
+                    return ch != Ch('\0') && ch != Ch('&');
+                }
+            };
+
             template<Ch Quote> struct AttributeValue
             {
                 static unsigned char Test(Ch ch)
@@ -1559,7 +1691,7 @@ namespace Cpl
                 return cdata;
             }
 
-            template<int Flags> XmlNode<Ch> * ParseElement(Ch *&text)
+            template<int Flags> XmlNode<Ch> * ParseElement(Ch *&text, size_t threads = 1)
             {
                 XmlNode<Ch> *element = this->AllocateNode(NodeElement);
                 Ch *name = text;
@@ -1567,12 +1699,17 @@ namespace Cpl
                 if (text == name)
                     throw ParseError("expected element name", text);
                 element->Name(name, text - name);
+                if (Flags & ParseInternNames)
+                    element->_nameId = InternName(name, text - name);
                 Skip<Whitespace, Flags>(text);
                 ParseNodeAttributes<Flags>(text, element);
                 if (*text == Ch('>'))
                 {
                     ++text;
-                    ParseNodeContents<Flags>(text, element);
+                    if (threads > 1)
+                        ParseNodeContentsParallel<Flags>(text, element, threads);
+                    else
+                        ParseNodeContents<Flags>(text, element);
                 }
                 else if (*text == Ch('/'))
                 {
@@ -1693,6 +1830,166 @@ namespace Cpl
                 }
             }
 
+            static Ch * ScanTo(Ch *text, const char *pattern, size_t size)
+            {
+                for (; *text; ++text)
+                {
+                    size_t i = 0;
+                    while (i < size && text[i] == Ch(pattern[i]))
+                        ++i;
+                    if (i == size)
+                        return text + size;
+                }
+                return 0;
+            }
+
+            static Ch * ScanChildren(Ch *text, std::vector<Ch*> & starts)
+            {
+                size_t depth = 0;
+                while (text)
+                {
+                    if (*text == Ch('\0'))
+                        return 0;
+                    if (*text != Ch('<'))
+                    {
+                        if (depth == 0 && !Whitespace::Test(*text))
+                            return 0;
+                        ++text;
+                        continue;
+                    }
+                    if (text[1] == Ch('/'))
+                    {
+                        if (depth == 0)
+                            return text;
+                        --depth;
+                        text = ScanTo(text, ">", 1);
+                        continue;
+                    }
+                    if (text[1] == Ch('!') && text[2] == Ch('[') && depth == 0)
+                        return 0;
+                    if (depth == 0)
+                        starts.push_back(text);
+                    if (text[1] == Ch('?'))
+                        text = ScanTo(text, "?>", 2);
+                    else if (text[1] == Ch('!') && text[2] == Ch('-') && text[3] == Ch('-'))
+                        text = ScanTo(text + 4, "-->", 3);
+                    else if (text[1] == Ch('!') && text[2] == Ch('['))
+                        text = ScanTo(text, "]]>", 3);
+                    else if (text[1] == Ch('!'))
+                        text = ScanTo(text, ">", 1);
+                    else
+                    {
+                        Ch quote = 0;
+                        for (++text; *text && (quote || *text != Ch('>')); ++text)
+                        {
+                            if (quote && *text == quote)
+                                quote = 0;
+                            else if (!quote && (*text == Ch('\'') || *text == Ch('"')))
+                                quote = *text;
+                        }
+                        if (*text == Ch('\0'))
+                            return 0;
+                        if (text[-1] != Ch('/'))
+                            ++depth;
+                        ++text;
+                    }
+                }
+                return 0;
+            }
+
+            template<int Flags> void ParsePart(Ch *text, Ch *end)
+            {
+                this->RemoveAllNodes();
+                ClearNames();
+                while (1)
+                {
+                    if (XmlNode<Ch> *node = ParseNode<Flags>(text))
+                        this->AppendNode(node);
+                    Skip<Whitespace, Flags>(text);
+                    if (text >= end)
+                        break;
+                    if (*text != Ch('<'))
+                        throw ParseError("expected <", text);
+                    ++text;
+                }
+            }
+
+            template<int Flags> void ParseNodeContentsParallel(Ch *&text, XmlNode<Ch> * node, size_t threads)
+            {
+                std::vector<Ch*> starts, bounds;
+                Ch *end = ScanChildren(text, starts);
+                if (end == 0 || starts.size() < 2)
+                {
+                    ParseNodeContents<Flags>(text, node);
+                    return;
+                }
+                bounds.push_back(starts[0]);
+                for (size_t i = 1; i < threads; ++i)
+                {
+                    Ch *target = text + (end - text) * i / threads;
+                    typename std::vector<Ch*>::iterator start = std::lower_bound(starts.begin(), starts.end(), target);
+                    if (start != starts.end() && *start > bounds.back())
+                        bounds.push_back(*start);
+                }
+                bounds.push_back(end);
+                size_t parts = bounds.size() - 1;
+                while (_parts.size() < parts)
+                    _parts.push_back(std::unique_ptr<XmlDocument>(new XmlDocument()));
+                // Every chunk starts with '<' at its bound. Terminating the bounds keeps a worker inside its chunk if the pre-scan was wrong.
+                for (size_t i = 0; i <= parts; ++i)
+                    *bounds[i] = Ch('\0');
+                std::vector<std::exception_ptr> errors(parts);
+                std::vector<std::thread> workers;
+                for (size_t i = 0; i < parts; ++i)
+                {
+                    XmlDocument *part = _parts[i].get();
+                    Ch *begin = bounds[i] + 1, *stop = bounds[i + 1];
+                    std::exception_ptr *error = &errors[i];
+                    auto work = [part, begin, stop, error]()
+                    {
+                        try
+                        {
+                            part->template ParsePart<Flags>(begin, stop);
+                        }
+                        catch (...)
+                        {
+                            *error = std::current_exception();
+                        }
+                    };
+                    if (i + 1 < parts)
+                        workers.push_back(std::thread(work));
+                    else
+                        work();
+                }
+                for (size_t i = 0; i < workers.size(); ++i)
+                    workers[i].join();
+                for (size_t i = 0; i <= parts; ++i)
+                    *bounds[i] = Ch('<');
+                for (size_t i = 0; i < parts; ++i)
+                    if (errors[i])
+                        std::rethrow_exception(errors[i]);
+                std::vector<size_t> remap;
+                for (size_t i = 0; i < parts; ++i)
+                {
+                    XmlDocument *part = _parts[i].get();
+                    if (Flags & ParseInternNames)
+                    {
+                        remap.assign(1, 0);
+                        for (size_t j = 0; j < part->_names.size(); ++j)
+                            remap.push_back(InternName(part->_names[j]));
+                    }
+                    while (XmlNode<Ch> *child = part->FirstNode())
+                    {
+                        part->RemoveFirstNode();
+                        if (Flags & ParseInternNames)
+                            RemapNames(child, remap);
+                        node->AppendNode(child);
+                    }
+                }
+                text = end;
+                ParseNodeContents<Flags>(text, node);
+            }
+
             template<int Flags> void ParseNodeAttributes(Ch *&text, XmlNode<Ch> *node)
             {
                 while (AttributeName::Test(*text))
@@ -1704,6 +2001,8 @@ namespace Cpl
                         throw ParseError("expected attribute name", name);
                     XmlAttribute<Ch> *attribute = this->AllocateAttribute();
                     attribute->Name(name, text - name);
+                    if (Flags & ParseInternNames)
+                        attribute->_nameId = InternName(name, text - name);
                     node->AppendAttribute(attribute);
                     Skip<Whitespace, Flags>(text);
                     if (*text != Ch('='))
@@ -1731,8 +2030,435 @@ namespace Cpl
                     Skip<Whitespace, Flags>(text);
                 }
             }
+
+            struct InternedName
+            {
+                const Ch *name;
+                size_t size, hash;
+            };
+
+            static size_t NameHash(const Ch *name, size_t size)
+            {
+                size_t hash = size_t(14695981039346656037ULL);
+                for (const Ch *end = name + size; name < end; ++name)
+                    hash = (hash ^ size_t(*name)) * size_t(1099511628211ULL);
+                return hash;
+            }
+
+            static CPL_INLINE bool Equal(const InternedName &interned, const Ch *name, size_t size, size_t hash)
+            {
+                return interned.hash == hash && interned.size == size && memcmp(interned.name, name, size * sizeof(Ch)) == 0;
+            }
+
+            void ClearNames()
+            {
+                _names.clear();
+                _nameIndex.clear();
+            }
+
+            size_t InternName(const Ch *name, size_t size)
+            {
+                InternedName interned = { name, size, NameHash(name, size) };
+                return InternName(interned);
+            }
+
+            size_t InternName(const InternedName &interned)
+            {
+                if ((_names.size() + 1) * 2 > _nameIndex.size())
+                {
+                    _nameIndex.assign(std::max<size_t>(64, _nameIndex.size() * 2), 0);
+                    for (size_t id = 1; id <= _names.size(); ++id)
+                        _nameIndex[FreeSlot(_names[id - 1].hash)] = id;
+                }
+                size_t mask = _nameIndex.size() - 1, i = interned.hash & mask;
+                for (; _nameIndex[i]; i = (i + 1) & mask)
+                    if (Equal(_names[_nameIndex[i] - 1], interned.name, interned.size, interned.hash))
+                        return _nameIndex[i];
+                _names.push_back(interned);
+                return _nameIndex[i] = _names.size();
+            }
+
+            size_t FreeSlot(size_t hash) const
+            {
+                size_t mask = _nameIndex.size() - 1, i = hash & mask;
+                while (_nameIndex[i])
+                    i = (i + 1) & mask;
+                return i;
+            }
+
+            static void RemapNames(XmlNode<Ch> *node, const std::vector<size_t> &remap)
+            {
+                node->_nameId = remap[node->_nameId];
+                for (XmlAttribute<Ch> *attribute = node->FirstAttribute(); attribute; attribute = attribute->NextAttribute())
+                    attribute->_nameId = remap[attribute->_nameId];
+                for (XmlNode<Ch> *child = node->FirstNode(); child; child = child->NextSibling())
+                    RemapNames(child, remap);
+            }
+
+            std::vector<std::unique_ptr<XmlDocument>> _parts;
+            std::vector<InternedName> _names;
+            std::vector<size_t> _nameIndex;
+        };
+
+        enum XmlEventType
+        {
+            EventStartElement,
+            EventAttribute,
+            EventText,
+            EventEndElement,
+            EventNeedMore,
+            EventEnd
+        };
+
+        template<class Ch = char> struct XmlEvent
+        {
+            XmlEventType type;
+            const Ch* name;
+            size_t nameSize;
+            const Ch* value;
+            size_t valueSize;
+
+            XmlEvent(XmlEventType t = EventEnd, const Ch* n = 0, size_t ns = 0, const Ch* v = 0, size_t vs = 0)
+                : type(t)
+                , name(n)
+                , nameSize(ns)
+                , value(v)
+                , valueSize(vs)
+            {
+            }
+        };
+
+        template<class Ch, int Flags> class XmlReader
+        {
+        public:
+            XmlReader()
+            {
+                Clear();
+            }
+
+            void Feed(const Ch* data, size_t size)
+            {
+                assert(!_finished && _event == _events.size());
+                if (_begin)
+                {
+                    std::copy(_buffer.begin() + _begin, _buffer.begin() + _end, _buffer.begin());
+                    _end -= _begin;
+                    _begin = 0;
+                }
+                if (_end + size + 1 > _buffer.size())
+                    _buffer.resize(std::max(_end + size + 1, _buffer.size() * 2));
+                std::copy(data, data + size, _buffer.begin() + _end);
+                _end += size;
+                _buffer[_end] = Ch('\0');
+            }
+
+            void Finish()
+            {
+                _finished = true;
+            }
+
+            bool Next(XmlEvent<Ch>& event)
+            {
+                while (_event == _events.size())
+                {
+                    _events.clear();
+                    _event = 0;
+                    if (!ReadToken())
+                    {
+                        event = XmlEvent<Ch>(_finished ? EventEnd : EventNeedMore);
+                        return false;
+                    }
+                }
+                event = _events[_event++];
+                return true;
+            }
+
+            size_t Depth() const
+            {
+                return _depth;
+            }
+
+            void Clear()
+            {
+                _buffer.assign(1, Ch('\0'));
+                _events.clear();
+                _names.clear();
+                _begin = 0;
+                _end = 0;
+                _scan = 0;
+                _event = 0;
+                _depth = 0;
+                _quote = Ch('\0');
+                _started = false;
+                _finished = false;
+            }
+
+        private:
+            typedef XmlDocument<Ch> Document;
+            typedef typename Document::Whitespace Whitespace;
+            typedef typename Document::NodeName NodeName;
+            typedef typename Document::AttributeName AttributeName;
+            typedef std::basic_string<Ch> Name;
+
+            std::vector<Ch> _buffer;
+            std::vector<XmlEvent<Ch>> _events;
+            std::vector<Name> _names;
+            size_t _begin, _end, _scan, _event, _depth;
+            Ch _quote;
+            bool _started, _finished;
+
+            bool ReadToken()
+            {
+                Ch* text = _buffer.data() + _begin, * end = _buffer.data() + _end;
+                if (!_started)
+                {
+                    if (end - text < 3 && !_finished)
+                        return false;
+                    if (end - text >= 3 &&
+                        static_cast<unsigned char>(text[0]) == 0xEF &&
+                        static_cast<unsigned char>(text[1]) == 0xBB &&
+                        static_cast<unsigned char>(text[2]) == 0xBF)
+                        Consume(text += 3);
+                    _started = true;
+                }
+                if (text == end)
+                {
+                    if (_finished && _depth)
+                        throw ParseError("unexpected end of data", text);
+                    return false;
+                }
+                if (*text != Ch('<'))
+                {
+                    Ch* stop = Search(text, end, 0, "<", 1);
+                    if (stop == 0)
+                    {
+                        if (!_finished)
+                            return false;
+                        stop = end;
+                    }
+                    ReadText(text, stop);
+                    Consume(stop);
+                    return true;
+                }
+                if (end - text < (text[1] == Ch('!') ? 9 : 2) && !_finished)
+                    return false;
+                Ch* stop = 0;
+                if (text[1] == Ch('/'))
+                {
+                    if ((stop = Search(text, end, 2, ">", 1)) != 0)
+                        ReadEndElement(text + 2, stop);
+                }
+                else if (text[1] == Ch('?'))
+                {
+                    if ((stop = Search(text, end, 2, "?>", 2)) != 0)
+                        stop += 1;
+                }
+                else if (text[1] == Ch('!'))
+                {
+                    if (text[2] == Ch('-') && text[3] == Ch('-'))
+                    {
+                        if ((stop = Search(text, end, 4, "-->", 3)) != 0)
+                            stop += 2;
+                    }
+                    else if (Match(text + 2, "[CDATA[", 7))
+                    {
+                        if ((stop = Search(text, end, 9, "]]>", 3)) != 0)
+                        {
+                            if (!(Flags & ParseNoDataNodes) && _depth)
+                                _events.push_back(XmlEvent<Ch>(EventText, 0, 0, text + 9, stop - text - 9));
+                            stop += 2;
+                        }
+                    }
+                    else if (Match(text + 2, "DOCTYPE", 7))
+                        stop = SearchDocType(text + 9, end);
+                    else
+                        stop = Search(text, end, 2, ">", 1);
+                }
+                else
+                {
+                    if ((stop = SearchTagEnd(text, end)) != 0)
+                        ReadStartElement(text + 1, stop);
+                }
+                if (stop == 0)
+                {
+                    if (_finished)
+                        throw ParseError("unexpected end of data", end);
+                    return false;
+                }
+                Consume(stop + 1);
+                return true;
+            }
+
+            Ch* Search(Ch* text, Ch* end, size_t offset, const char* pattern, size_t size)
+            {
+                for (Ch* p = text + std::max(offset, _scan); p + size <= end; ++p)
+                {
+                    if (Match(p, pattern, size))
+                        return p;
+                }
+                _scan = std::max(offset, size_t(end - text) - std::min(size_t(end - text), size - 1));
+                return 0;
+            }
+
+            static bool Match(const Ch* text, const char* pattern, size_t size)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    if (text[i] != Ch(pattern[i]))
+                        return false;
+                return true;
+            }
+
+            Ch* SearchTagEnd(Ch* text, Ch* end)
+            {
+                for (Ch* p = text + std::max<size_t>(1, _scan); p < end; ++p)
+                {
+                    if (_quote)
+                    {
+                        if (*p == _quote)
+                            _quote = Ch('\0');
+                    }
+                    else if (*p == Ch('\'') || *p == Ch('"'))
+                        _quote = *p;
+                    else if (*p == Ch('>'))
+                        return p;
+                }
+                _scan = end - text;
+                return 0;
+            }
+
+            Ch* SearchDocType(Ch* text, Ch* end)
+            {
+                for (int depth = 0; text < end; ++text)
+                {
+                    if (*text == Ch('['))
+                        ++depth;
+                    else if (*text == Ch(']'))
+                        --depth;
+                    else if (*text == Ch('>') && depth == 0)
+                        return text;
+                }
+                return 0;
+            }
+
+            void Consume(Ch* text)
+            {
+                _begin = text - _buffer.data();
+                _scan = 0;
+                _quote = Ch('\0');
+            }
+
+            void ReadText(Ch* text, Ch* stop)
+            {
+                Ch* start = text;
+                Document::template Skip<Whitespace, Flags>(text);
+                if (text == stop)
+                    return;
+                if (_depth == 0)
+                    throw ParseError("expected <", text);
+                if (!(Flags & ParseTrimWhitespace))
+                    text = start;
+                Ch* value = text, * end;
+                if (Flags & ParseNormalizeWhitespace)
+                    end = Document::template SkipAndExpandCharacterRefs<typename Document::Text, typename Document::TextPureWithWs, Flags>(text);
+                else
+                    end = Document::template SkipAndExpandCharacterRefs<typename Document::Text, typename Document::TextPureNoWs, Flags>(text);
+                if (Flags & ParseTrimWhitespace)
+                {
+                    if (Flags & ParseNormalizeWhitespace)
+                    {
+                        if (*(end - 1) == Ch(' '))
+                            --end;
+                    }
+                    else
+                    {
+                        while (Whitespace::Test(*(end - 1)))
+                            --end;
+                    }
+                }
+                if (!(Flags & ParseNoDataNodes))
+                    _events.push_back(XmlEvent<Ch>(EventText, 0, 0, value, end - value));
+            }
+
+            void ReadStartElement(Ch* text, Ch* stop)
+            {
+                Ch* name = text;
+                Document::template Skip<NodeName, Flags>(text);
+                if (text == name)
+                    throw ParseError("expected element name", text);
+                size_t nameSize = text - name;
+                _events.push_back(XmlEvent<Ch>(EventStartElement, name, nameSize));
+                Document::template Skip<Whitespace, Flags>(text);
+                while (AttributeName::Test(*text))
+                {
+                    Ch* attrName = text;
+                    ++text;
+                    Document::template Skip<AttributeName, Flags>(text);
+                    size_t attrNameSize = text - attrName;
+                    Document::template Skip<Whitespace, Flags>(text);
+                    if (*text != Ch('='))
+                        throw ParseError("expected =", text);
+                    ++text;
+                    Document::template Skip<Whitespace, Flags>(text);
+                    Ch quote = *text;
+                    if (quote != Ch('\'') && quote != Ch('"'))
+                        throw ParseError("expected ' or \"", text);
+                    ++text;
+                    Ch* value = text, * end;
+                    const int AttFlags = Flags & ~ParseNormalizeWhitespace;
+                    if (quote == Ch('\''))
+                        end = Document::template SkipAndExpandCharacterRefs<typename Document::template AttributeValue<Ch('\'')>, typename Document::template AttributeValuePure<Ch('\'')>, AttFlags>(text);
+                    else
+                        end = Document::template SkipAndExpandCharacterRefs<typename Document::template AttributeValue<Ch('"')>, typename Document::template AttributeValuePure<Ch('"')>, AttFlags>(text);
+                    if (*text != quote)
+                        throw ParseError("expected ' or \"", text);
+                    ++text;
+                    _events.push_back(XmlEvent<Ch>(EventAttribute, attrName, attrNameSize, value, end - value));
+                    Document::template Skip<Whitespace, Flags>(text);
+                }
+                if (text == stop)
+                {
+                    if (Flags & ParseValidateClosingTags)
+                        _names.push_back(Name(name, nameSize));
+                    ++_depth;
+                }
+                else if (*text == Ch('/') && text + 1 == stop)
+                    _events.push_back(XmlEvent<Ch>(EventEndElement, name, nameSize));
+                else
+                    throw ParseError("expected >", text);
+            }
+
+            void ReadEndElement(Ch* text, Ch* stop)
+            {
+                Ch* name = text;
+                Document::template Skip<NodeName, Flags>(text);
+                size_t nameSize = text - name;
+                if (_depth == 0)
+                    throw ParseError("unexpected closing tag", name);
+                if (Flags & ParseValidateClosingTags)
+                {
+                    if (!Internal::Compare(_names.back().c_str(), _names.back().size(), name, nameSize, true))
+                        throw ParseError("invalid closing tag name", text);
+                    _names.pop_back();
+                }
+                Document::template Skip<Whitespace, Flags>(text);
+                if (text != stop)
+                    throw ParseError("expected >", text);
+                _events.push_back(XmlEvent<Ch>(EventEndElement, name, nameSize));
+                --_depth;
+            }
         };
 
+        template<class Ch> inline std::basic_string<Ch> ExpandedValue(const XmlBase<Ch> * base)
+        {
+            std::basic_string<Ch> value(base->Value(), base->ValueSize());
+            if (value.find(Ch('&')) != std::basic_string<Ch>::npos)
+            {
+                Ch * begin = &value[0];
+                value.resize(XmlDocument<Ch>::ExpandEntities(begin) - begin);
+            }
+            return value;
+        }
+
         template<class Ch> class NodeIterator
         {
         public:
@@ -1883,6 +2609,50 @@ namespace Cpl
 
         };
 
+        template<class Ch = char> class OutputIterator
+        {
+        public:
+            typedef std::output_iterator_tag iterator_category;
+            typedef void value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef void pointer;
+            typedef void reference;
+
+            OutputIterator(OutputBuffer<Ch>* buffer)
+                : _buffer(buffer)
+            {
+            }
+
+            OutputIterator& operator = (Ch ch)
+            {
+                _buffer->Write(ch);
+                return *this;
+            }
+
+            OutputIterator& operator * ()
+            {
+                return *this;
+            }
+
+            OutputIterator& operator ++ ()
+            {
+                return *this;
+            }
+
+            OutputIterator& operator ++ (int)
+            {
+                return *this;
+            }
+
+            OutputBuffer<Ch>* Buffer() const
+            {
+                return _buffer;
+            }
+
+        private:
+            OutputBuffer<Ch>* _buffer;
+        };
+
         const int PrintNoIndenting = 0x1;
 
         namespace Internal
@@ -1937,6 +2707,51 @@ namespace Cpl
                 return out;
             }
 
+            template<class Ch> inline OutputIterator<Ch> CopyChars(const Ch* begin, const Ch* end, OutputIterator<Ch> out)
+            {
+                out.Buffer()->Write(begin, end - begin);
+                return out;
+            }
+
+            template<class Ch> inline OutputIterator<Ch> CopyAndExpandChars(const Ch* begin, const Ch* end, Ch noexpand, OutputIterator<Ch> out)
+            {
+                static const Ch lt[] = { Ch('&'), Ch('l'), Ch('t'), Ch(';') };
+                static const Ch gt[] = { Ch('&'), Ch('g'), Ch('t'), Ch(';') };
+                static const Ch apos[] = { Ch('&'), Ch('a'), Ch('p'), Ch('o'), Ch('s'), Ch(';') };
+                static const Ch quot[] = { Ch('&'), Ch('q'), Ch('u'), Ch('o'), Ch('t'), Ch(';') };
+                static const Ch amp[] = { Ch('&'), Ch('a'), Ch('m'), Ch('p'), Ch(';') };
+                OutputBuffer<Ch>* buffer = out.Buffer();
+                const Ch* run = begin;
+                for (; begin != end; ++begin)
+                {
+                    const Ch* entity = NULL;
+                    size_t size = 0;
+                    if (*begin == noexpand)
+                        continue;
+                    switch (*begin)
+                    {
+                    case Ch('<'): entity = lt, size = sizeof(lt) / sizeof(Ch); break;
+                    case Ch('>'): entity = gt, size = sizeof(gt) / sizeof(Ch); break;
+                    case Ch('\''): entity = apos, size = sizeof(apos) / sizeof(Ch); break;
+                    case Ch('"'): entity = quot, size = sizeof(quot) / sizeof(Ch); break;
+                    case Ch('&'): entity = amp, size = sizeof(amp) / sizeof(Ch); break;
+                    default: continue;
+                    }
+                    buffer->Write(run, begin - run);
+                    buffer->Write(entity, size);
+                    run = begin + 1;
+                }
+                buffer->Write(run, end - run);
+                return out;
+            }
+
+            template<class Ch> inline OutputIterator<Ch> FillChars(OutputIterator<Ch> out, int n, Ch ch)
+            {
+                if (n > 0)
+                    out.Buffer()->Fill(ch, size_t(n));
+                return out;
+            }
+
             template<class Ch, Ch ch> inline bool FindChar(const Ch *begin, const Ch *end)
             {
                 while (begin != end)
@@ -2162,10 +2977,30 @@ namespace Cpl
 
         template<class Ch> inline std::basic_ostream<Ch> & Print(std::basic_ostream<Ch> &out, const XmlNode<Ch> &node, int flags = 0)
         {
-            Print(std::ostream_iterator<Ch>(out), node, flags);
+            OutputBuffer<Ch> buffer(FlushToStream<Ch>, &out);
+            Print(OutputIterator<Ch>(&buffer), node, flags);
             return out;
         }
 
+        template<class Ch> inline std::basic_string<Ch> & PrintToString(std::basic_string<Ch> &str, const XmlNode<Ch> &node, int flags = 0)
+        {
+            OutputBuffer<Ch> buffer(FlushToString<Ch>, &str);
+            Print(OutputIterator<Ch>(&buffer), node, flags);
+            return str;
+        }
+
+        template<class Ch> inline bool PrintToFile(const char * fileName, const XmlNode<Ch> &node, int flags = 0)
+        {
+            std::basic_ofstream<Ch> ofs;
+            ofs.rdbuf()->pubsetbuf(0, 0);
+            ofs.open(fileName, std::ios::binary);
+            if (!ofs)
+                return false;
+            Print((std::basic_ostream<Ch>&)ofs, node, flags);
+            ofs.close();
+            return !ofs.fail();
+        }
+
         template<class Ch> inline std::basic_ostream<Ch> & operator <<(std::basic_ostream<Ch> & out, const XmlNode<Ch> & node)
         {
             return Print(out, node);
@@ -0,0 +1,371 @@
+/*
+* Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include "Cpl/Xml.h"
+
+#include <unordered_set>
+
+namespace Cpl
+{
+    namespace Xml
+    {
+        /*
+        * Compiled subset of XPath:
+        *   /a/b      - children of the document (absolute path) or of the context node;
+        *   //a       - descendants at any depth;
+        *   *         - any element;
+        *   a[2]      - 1-based position among matching children of each parent;
+        *   a[@k]     - element has attribute 'k';
+        *   a[@k='v'] - element has attribute 'k' with value 'v';
+        *   a/@k      - attribute 'k' of selected elements (only as the last step).
+        * A step has at most one predicate: a[@k][2] and other chains of predicates are rejected with ParseError.
+        * Names are compared by id if the document was parsed with ParseInternNames.
+        */
+        template<class Ch = char> class XmlPath
+        {
+        public:
+            typedef std::basic_string<Ch> String;
+            typedef std::vector<XmlNode<Ch>*> Nodes;
+            typedef std::vector<XmlAttribute<Ch>*> Attributes;
+
+            XmlPath()
+                : _absolute(false)
+                , _descendants(0)
+            {
+            }
+
+            XmlPath(const Ch * path, size_t size = 0)
+            {
+                Compile(path, size);
+            }
+
+            void Compile(const Ch * path, size_t size = 0)
+            {
+                _steps.clear();
+                _absolute = false;
+                _descendants = 0;
+                const Ch * text = path, * end = path + (size ? size : Internal::Measure(path));
+                if (text < end && *text == Ch('/') && !(text + 1 < end && text[1] == Ch('/')))
+                {
+                    _absolute = true;
+                    ++text;
+                }
+                while (text < end)
+                {
+                    Step step;
+                    if (*text == Ch('/'))
+                    {
+                        if (text + 1 < end && text[1] == Ch('/'))
+                        {
+                            step.descendant = true;
+                            _absolute = _absolute || text == path;
+                            _descendants++;
+                            text += 2;
+                        }
+                        else if (_steps.empty())
+                            throw ParseError("unexpected /", (void*)text);
+                        else
+                            ++text;
+                    }
+                    else if (!_steps.empty())
+                        throw ParseError("expected /", (void*)text);
+                    if (text < end && *text == Ch('@'))
+                    {
+                        step.attribute = true;
+                        ++text;
+                    }
+                    if (text < end && *text == Ch('*'))
+                        ++text;
+                    else
+                        step.name = ParseName(text, end);
+                    if (text < end && *text == Ch('['))
+                        ParsePredicate(++text, end, step);
+                    if (text < end && *text == Ch('['))
+                        throw ParseError("only one predicate per step is supported", (void*)text);
+                    if (step.attribute && (step.descendant || step.index || step.key.size()))
+                        throw ParseError("unsupported attribute step", (void*)text);
+                    if (!_steps.empty() && _steps.back().attribute)
+                        throw ParseError("attribute step must be the last", (void*)text);
+                    _steps.push_back(step);
+                }
+                if (_steps.empty())
+                    throw ParseError("empty path", (void*)path);
+            }
+
+            bool Empty() const
+            {
+                return _steps.empty();
+            }
+
+            bool Attribute() const
+            {
+                return _steps.size() && _steps.back().attribute;
+            }
+
+            XmlNode<Ch> * First(const XmlNode<Ch> * context) const
+            {
+                assert(!Attribute());
+                XmlNode<Ch> * result = 0;
+                Ids ids;
+                XmlNode<Ch> * node = Context(context, ids);
+                Visit(0, node, Data(ids), [&result](XmlBase<Ch> * node) { result = (XmlNode<Ch>*)node; return false; });
+                return result;
+            }
+
+            size_t Select(const XmlNode<Ch> * context, Nodes & nodes) const
+            {
+                assert(!Attribute());
+                return Collect(context, nodes);
+            }
+
+            XmlAttribute<Ch> * FirstAttribute(const XmlNode<Ch> * context) const
+            {
+                assert(Attribute());
+                XmlAttribute<Ch> * result = 0;
+                Ids ids;
+                XmlNode<Ch> * node = Context(context, ids);
+                Visit(0, node, Data(ids), [&result](XmlBase<Ch> * attribute) { result = (XmlAttribute<Ch>*)attribute; return false; });
+                return result;
+            }
+
+            size_t SelectAttributes(const XmlNode<Ch> * context, Attributes & attributes) const
+            {
+                assert(Attribute());
+                return Collect(context, attributes);
+            }
+
+        private:
+            struct Step
+            {
+                bool descendant, attribute;
+                String name, key, value;
+                bool hasKey, hasValue;
+                size_t index;
+
+                Step()
+                    : descendant(false)
+                    , attribute(false)
+                    , hasKey(false)
+                    , hasValue(false)
+                    , index(0)
+                {
+                }
+
+                static CPL_INLINE bool Match(const XmlBase<Ch> * base, const String & name, size_t id)
+                {
+                    if (id && base->NameId())
+                        return base->NameId() == id;
+                    return base->NameSize() == name.size() && memcmp(base->Name(), name.data(), name.size() * sizeof(Ch)) == 0;
+                }
+
+                CPL_INLINE bool Match(const XmlBase<Ch> * base, const size_t * ids) const
+                {
+                    return name.empty() || Match(base, name, ids ? ids[0] : 0);
+                }
+
+                CPL_INLINE bool Match(const XmlNode<Ch> * node, const size_t * ids) const
+                {
+                    if (node->Type() != NodeElement || !Match((const XmlBase<Ch>*)node, ids))
+                        return false;
+                    if (hasKey)
+                    {
+                        for (XmlAttribute<Ch> * attribute = node->FirstAttribute(); attribute; attribute = attribute->NextAttribute())
+                        {
+                            if (Match(attribute, key, ids ? ids[1] : 0) && (!hasValue || (attribute->ValueSize() == value.size() &&
+                                memcmp(attribute->Value(), value.data(), value.size() * sizeof(Ch)) == 0)))
+                                return true;
+                        }
+                        return false;
+                    }
+                    return true;
+                }
+            };
+            typedef std::vector<Step> Steps;
+            typedef std::vector<size_t> Ids;
+
+            Steps _steps;
+            bool _absolute;
+            size_t _descendants;
+
+            static bool Delimiter(Ch ch)
+            {
+                return ch == Ch('/') || ch == Ch('[') || ch == Ch(']') || ch == Ch('@') || ch == Ch('=') ||
+                    ch == Ch('*') || ch == Ch('\'') || ch == Ch('"') || ch == Ch(' ') || ch == Ch('\t');
+            }
+
+            static String ParseName(const Ch *& text, const Ch * end)
+            {
+                const Ch * name = text;
+                while (text < end && !Delimiter(*text))
+                    ++text;
+                if (text == name)
+                    throw ParseError("expected name", (void*)text);
+                return String(name, text - name);
+            }
+
+            static void ParsePredicate(const Ch *& text, const Ch * end, Step & step)
+            {
+                if (text < end && *text == Ch('@'))
+                {
+                    step.key = ParseName(++text, end);
+                    step.hasKey = true;
+                    if (text < end && *text == Ch('='))
+                    {
+                        ++text;
+                        Ch quote = text < end ? *text : Ch(0);
+                        if (quote != Ch('\'') && quote != Ch('"'))
+                            throw ParseError("expected ' or \"", (void*)text);
+                        const Ch * value = ++text;
+                        while (text < end && *text != quote)
+                            ++text;
+                        if (text == end)
+                            throw ParseError("expected ' or \"", (void*)text);
+                        step.value = String(value, text - value);
+                        step.hasValue = true;
+                        ++text;
+                    }
+                }
+                else
+                {
+                    size_t index = 0;
+                    const Ch * start = text;
+                    for (; text < end && *text >= Ch('0') && *text <= Ch('9'); ++text)
+                        index = index * 10 + size_t(*text - Ch('0'));
+                    if (text == start || index == 0)
+                        throw ParseError("expected positive index", (void*)text);
+                    step.index = index;
+                }
+                if (text == end || *text != Ch(']'))
+                    throw ParseError("expected ]", (void*)text);
+                ++text;
+            }
+
+            XmlNode<Ch> * Context(const XmlNode<Ch> * context, Ids & ids) const
+            {
+                XmlNode<Ch> * root = const_cast<XmlNode<Ch>*>(context);
+                while (root->Parent())
+                    root = root->Parent();
+                if (root->Type() == NodeDocument && ((XmlDocument<Ch>*)root)->NameCount())
+                {
+                    const XmlDocument<Ch> * document = (XmlDocument<Ch>*)root;
+                    ids.resize(_steps.size() * 2);
+                    for (size_t i = 0; i < _steps.size(); ++i)
+                    {
+                        ids[i * 2 + 0] = NameId(document, _steps[i].name);
+                        ids[i * 2 + 1] = NameId(document, _steps[i].key);
+                    }
+                }
+                return _absolute ? root : const_cast<XmlNode<Ch>*>(context);
+            }
+
+            static size_t NameId(const XmlDocument<Ch> * document, const String & name)
+            {
+                if (name.empty())
+                    return 0;
+                size_t id = document->NameId(name.data(), name.size());
+                return id ? id : size_t(-1);
+            }
+
+            static const size_t * Data(const Ids & ids)
+            {
+                return ids.empty() ? 0 : ids.data();
+            }
+
+            template<class Container> size_t Collect(const XmlNode<Ch> * context, Container & container) const
+            {
+                typedef typename Container::value_type Pointer;
+                size_t size = container.size();
+                Ids ids;
+                XmlNode<Ch> * node = Context(context, ids);
+                if (_descendants > 1)
+                {
+                    std::unordered_set<XmlBase<Ch>*> unique;
+                    Visit(0, node, Data(ids), [&container, &unique](XmlBase<Ch> * base)
+                    {
+                        if (unique.insert(base).second)
+                            container.push_back((Pointer)base);
+                        return true;
+                    });
+                }
+                else
+                    Visit(0, node, Data(ids), [&container](XmlBase<Ch> * base) { container.push_back((Pointer)base); return true; });
+                return container.size() - size;
+            }
+
+            template<class Callback> bool Visit(size_t index, XmlNode<Ch> * node, const size_t * ids, Callback callback) const
+            {
+                const Step & step = _steps[index];
+                if (step.attribute)
+                {
+                    for (XmlAttribute<Ch> * attribute = node->FirstAttribute(); attribute; attribute = attribute->NextAttribute())
+                        if (step.Match((const XmlBase<Ch>*)attribute, ids ? ids + index * 2 : 0) && !callback(attribute))
+                            return false;
+                    return true;
+                }
+                if (step.descendant)
+                    return VisitDescendants(index, node, ids, callback);
+                return VisitChildren(index, node, ids, callback);
+            }
+
+            template<class Callback> bool VisitDescendants(size_t index, XmlNode<Ch> * node, const size_t * ids, Callback & callback) const
+            {
+                const Step & step = _steps[index];
+                size_t position = 0;
+                for (XmlNode<Ch> * child = node->FirstNode(); child; child = child->NextSibling())
+                {
+                    if (step.Match(child, ids ? ids + index * 2 : 0) && (!step.index || ++position == step.index) && !VisitMatch(index, child, ids, callback))
+                        return false;
+                    if (child->Type() == NodeElement && !VisitDescendants(index, child, ids, callback))
+                        return false;
+                }
+                return true;
+            }
+
+            template<class Callback> bool VisitChildren(size_t index, XmlNode<Ch> * node, const size_t * ids, Callback & callback) const
+            {
+                const Step & step = _steps[index];
+                size_t position = 0;
+                for (XmlNode<Ch> * child = node->FirstNode(); child; child = child->NextSibling())
+                {
+                    if (!step.Match(child, ids ? ids + index * 2 : 0))
+                        continue;
+                    if (step.index && ++position != step.index)
+                        continue;
+                    if (!VisitMatch(index, child, ids, callback))
+                        return false;
+                    if (step.index)
+                        break;
+                }
+                return true;
+            }
+
+            template<class Callback> bool VisitMatch(size_t index, XmlNode<Ch> * node, const size_t * ids, Callback & callback) const
+            {
+                return index + 1 == _steps.size() ? callback(node) : Visit(index + 1, node, ids, callback);
+            }
+        };
+    }
+}
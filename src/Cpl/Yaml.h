@@ -25,6 +25,9 @@
 #pragma once
 
 #include "Cpl/String.h"
+#include "Cpl/OutputBuffer.h"
+
+#include <cstring>
 
 namespace Cpl
 {
@@ -39,18 +42,14 @@ namespace Cpl
                 static T Get(const std::string& data)
                 {
                     T type;
-                    std::stringstream ss(data);
-                    ss >> type;
+                    Cpl::Detail::FromStr<T>::Get(data, type);
                     return type;
                 }
 
                 static T Get(const std::string& data, const T& defaultValue)
                 {
                     T type;
-                    std::stringstream ss(data);
-                    ss >> type;
-
-                    if (ss.fail())
+                    if (!Cpl::Detail::FromStr<T>::Get(data, type))
                     {
                         return defaultValue;
                     }
@@ -80,14 +79,7 @@ namespace Cpl
             {
                 static bool Get(const std::string& data)
                 {
-                    std::string tmpData = data;
-                    std::transform(tmpData.begin(), tmpData.end(), tmpData.begin(), ::tolower);
-                    if (tmpData == "true" || tmpData == "yes" || tmpData == "1")
-                    {
-                        return true;
-                    }
-
-                    return false;
+                    return data == "1" || Cpl::Detail::EqualNoCase(data, "true") || Cpl::Detail::EqualNoCase(data, "yes");
                 }
 
                 static bool Get(const std::string& data, const bool& defaultValue)
@@ -248,6 +240,7 @@ namespace Cpl
             Node(const Node& node);
 
             Node(const std::string& value);
+            Node(std::string&& value);
             Node(const char* value);
 
             ~Node();
@@ -270,6 +263,8 @@ namespace Cpl
                 return Detail::StringConverter<T>::Get(AsString(), defaultValue);
             }
 
+            const std::string& AsString() const;
+
             size_t Size() const;
 
             Node& Insert(const size_t index);
@@ -286,6 +281,7 @@ namespace Cpl
 
             Node& operator = (const Node& node);
             Node& operator = (const std::string& value);
+            Node& operator = (std::string&& value);
             Node& operator = (const char* value);
 
             Iterator Begin();
@@ -295,8 +291,6 @@ namespace Cpl
             ConstIterator End() const;
 
         private:
-            const std::string& AsString() const;
-
             void* m_pImp; ///< Implementation of node class.
         };
 
@@ -305,6 +299,33 @@ namespace Cpl
         void Parse(Node& root, const std::string& string);
         void Parse(Node& root, const char* buffer, const size_t size);
 
+        class ParseImp;
+
+        /*
+        * Reads a stream of documents separated by "---" (or ended by "...") one by one.
+        * Only the current document is kept in memory, the stream is read forward only.
+        */
+        class DocumentReader
+        {
+        public:
+            DocumentReader(std::istream& stream);
+            DocumentReader(const char* filename);
+            ~DocumentReader();
+
+            bool Next(Node& root);  ///< Parses next document to root. Returns false at the end of stream.
+            size_t Count() const;   ///< Number of read documents.
+
+        private:
+            DocumentReader(const DocumentReader& copy);
+
+            std::ifstream m_File;   ///< Owned file stream (if reader is created from file name).
+            std::istream& m_Stream; ///< Source stream.
+            ParseImp* m_pImp;       ///< Line parser.
+            size_t m_LineNo;        ///< Number of read lines.
+            size_t m_Count;         ///< Number of read documents.
+            bool m_Started;         ///< Next document is already started by "---".
+        };
+
         struct SerializeConfig
         {
             SerializeConfig(const size_t spaceIndentation = 2,
@@ -318,7 +339,7 @@ namespace Cpl
             bool MapScalarNewline;      ///< Put scalars on a new line if parent node is a map.
         };
 
-        void Serialize(const Node& root, const char* filename, const SerializeConfig& config = { 2, 64, false, false });
+        size_t Serialize(const Node& root, const char* filename, const SerializeConfig& config = { 2, 64, false, false });
         void Serialize(const Node& root, std::ostream& stream, const SerializeConfig& config = { 2, 64, false, false });
         void Serialize(const Node& root, std::string& string, const SerializeConfig& config = { 2, 64, false, false });
 
@@ -365,7 +386,7 @@ namespace Cpl
                 {
                     for (auto it = m_Sequence.begin(); it != m_Sequence.end(); it++)
                     {
-                        delete it->second;
+                        delete *it;
                     }
                 }
 
@@ -386,12 +407,7 @@ namespace Cpl
 
                 virtual Node* GetNode(const size_t index)
                 {
-                    auto it = m_Sequence.find(index);
-                    if (it != m_Sequence.end())
-                    {
-                        return it->second;
-                    }
-                    return nullptr;
+                    return index < m_Sequence.size() ? m_Sequence[index] : nullptr;
                 }
 
                 virtual Node* GetNode(const std::string& key)
@@ -401,81 +417,38 @@ namespace Cpl
 
                 virtual Node* Insert(const size_t index)
                 {
-                    if (m_Sequence.size() == 0)
-                    {
-                        Node* pNode = new Node;
-                        m_Sequence.insert({ 0, pNode });
-                        return pNode;
-                    }
-
-                    if (index >= m_Sequence.size())
-                    {
-                        auto it = m_Sequence.end();
-                        --it;
-                        Node* pNode = new Node;
-                        m_Sequence.insert({ it->first, pNode });
-                        return pNode;
-                    }
-
-                    auto it = m_Sequence.cbegin();
-                    while (it != m_Sequence.cend())
-                    {
-                        m_Sequence[it->first + 1] = it->second;
-
-                        if (it->first == index)
-                        {
-                            break;
-                        }
-                    }
-
                     Node* pNode = new Node;
-                    m_Sequence.insert({ index, pNode });
+                    m_Sequence.insert(m_Sequence.begin() + std::min(index, m_Sequence.size()), pNode);
                     return pNode;
                 }
 
                 virtual Node* PushFront()
                 {
-                    for (auto it = m_Sequence.cbegin(); it != m_Sequence.cend(); it++)
-                    {
-                        m_Sequence[it->first + 1] = it->second;
-                    }
-
-                    Node* pNode = new Node;
-                    m_Sequence.insert({ 0, pNode });
-                    return pNode;
+                    return Insert(0);
                 }
 
                 virtual Node* PushBack()
                 {
-                    size_t index = 0;
-                    if (m_Sequence.size())
-                    {
-                        auto it = m_Sequence.end();
-                        --it;
-                        index = it->first + 1;
-                    }
-
                     Node* pNode = new Node;
-                    m_Sequence.insert({ index, pNode });
+                    m_Sequence.push_back(pNode);
                     return pNode;
                 }
 
                 virtual void Erase(const size_t index)
                 {
-                    auto it = m_Sequence.find(index);
-                    if (it == m_Sequence.end())
+                    if (index >= m_Sequence.size())
                     {
                         return;
                     }
-                    delete it->second;
-                    m_Sequence.erase(index);
+                    delete m_Sequence[index];
+                    m_Sequence.erase(m_Sequence.begin() + index);
                 }
 
                 virtual void Erase(const std::string& key)
                 {
                 }
 
-                std::map<size_t, Node*> m_Sequence;
+                std::vector<Node*> m_Sequence;
             };
 
             //-------------------------------------------------------------------------------------
@@ -483,6 +456,9 @@ namespace Cpl
             class MapImp : public TypeImp
             {
             public:
+                typedef std::pair<std::string, Node*> Item;
+                typedef std::vector<Item> Items;
+
                 ~MapImp()
                 {
                     for (auto it = m_Map.begin(); it != m_Map.end(); it++)
@@ -513,14 +489,27 @@ namespace Cpl
 
                 virtual Node* GetNode(const std::string& key)
                 {
-                    auto it = m_Map.find(key);
-                    if (it == m_Map.end())
+                    const size_t hash = std::hash<std::string>()(key);
+                    const size_t index = Find(key, hash);
+                    if (index != m_Map.size())
+                    {
+                        return m_Map[index].second;
+                    }
+                    Node* pNode = new Node;
+                    m_Map.push_back(Item(key, pNode));
+                    m_Hashes.push_back(hash);
+                    if (m_Map.size() > LinearLimit)
                     {
-                        Node* pNode = new Node;
-                        m_Map.insert({ key, pNode });
-                        return pNode;
+                        if (m_Map.size() * 2 > m_Index.size())
+                        {
+                            Rebuild();
+                        }
+                        else
+                        {
+                            Place(index);
+                        }
                     }
-                    return it->second;
+                    return pNode;
                 }
 
                 virtual Node* Insert(const size_t index)
@@ -544,17 +533,120 @@ namespace Cpl
 
                 virtual void Erase(const std::string& key)
                 {
-                    auto it = m_Map.find(key);
-                    if (it == m_Map.end())
+                    const size_t index = Find(key, std::hash<std::string>()(key));
+                    if (index == m_Map.size())
                     {
                         return;
                     }
-                    delete it->second;
-                    m_Map.erase(key);
+                    delete m_Map[index].second;
+                    if (m_Index.size())
+                    {
+                        Remove(index);
+                        for (size_t i = index + 1; i < m_Map.size(); ++i)
+                        {
+                            m_Index[Slot(i)] = i;
+                        }
+                    }
+                    m_Map.erase(m_Map.begin() + index);
+                    m_Hashes.erase(m_Hashes.begin() + index);
+                    if (m_Map.size() <= LinearLimit)
+                    {
+                        m_Index.clear();
+                    }
+                }
+
+                Items m_Map;    ///< Items in insertion order.
+
+            private:
+                static const size_t LinearLimit = 8;
+
+                std::vector<size_t> m_Hashes;   ///< Key hashes of items.
+                std::vector<size_t> m_Index;    ///< Open-addressing table of item positions + 1 (used for big maps only).
+
+                size_t Find(const std::string& key, size_t hash) const
+                {
+                    if (m_Index.empty())
+                    {
+                        for (size_t i = 0; i < m_Map.size(); ++i)
+                        {
+                            if (m_Hashes[i] == hash && m_Map[i].first == key)
+                            {
+                                return i;
+                            }
+                        }
+                        return m_Map.size();
+                    }
+                    const size_t mask = m_Index.size() - 1;
+                    for (size_t slot = hash & mask; m_Index[slot]; slot = (slot + 1) & mask)
+                    {
+                        const size_t i = m_Index[slot] - 1;
+                        if (m_Hashes[i] == hash && m_Map[i].first == key)
+                        {
+                            return i;
+                        }
+                    }
+                    return m_Map.size();
+                }
+
+                void Place(size_t index)
+                {
+                    const size_t mask = m_Index.size() - 1;
+                    size_t slot = m_Hashes[index] & mask;
+                    while (m_Index[slot])
+                    {
+                        slot = (slot + 1) & mask;
+                    }
+                    m_Index[slot] = index + 1;
+                }
+
+                size_t Slot(size_t index) const
+                {
+                    const size_t mask = m_Index.size() - 1;
+                    size_t slot = m_Hashes[index] & mask;
+                    while (m_Index[slot] != index + 1)
+                    {
+                        slot = (slot + 1) & mask;
+                    }
+                    return slot;
                 }
 
-                std::map<std::string, Node*> m_Map;
+                // Backward shift deletion: moves following items of the probe chain into the freed slot.
+                void Remove(size_t index)
+                {
+                    const size_t mask = m_Index.size() - 1;
+                    size_t hole = Slot(index);
+                    m_Index[hole] = 0;
+                    for (size_t slot = (hole + 1) & mask; m_Index[slot]; slot = (slot + 1) & mask)
+                    {
+                        const size_t home = m_Hashes[m_Index[slot] - 1] & mask;
+                        if (hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot))
+                        {
+                            continue;
+                        }
+                        m_Index[hole] = m_Index[slot];
+                        m_Index[slot] = 0;
+                        hole = slot;
+                    }
+                }
 
+                void Rebuild()
+                {
+                    if (m_Map.size() <= LinearLimit)
+                    {
+                        m_Index.clear();
+                        return;
+                    }
+                    size_t capacity = LinearLimit * 4;
+                    while (capacity < m_Map.size() * 4)
+                    {
+                        capacity *= 2;
+                    }
+                    m_Index.assign(capacity, 0);
+                    for (size_t i = 0; i < m_Map.size(); ++i)
+                    {
+                        Place(i);
+                    }
+                }
             };
 
             //-------------------------------------------------------------------------------------
@@ -745,7 +837,7 @@ namespace Cpl
                     m_Iterator = it.m_Iterator;
                 }
 
-                std::map<size_t, Node*>::iterator m_Iterator;
+                std::vector<Node*>::iterator m_Iterator;
 
             };
 
@@ -784,7 +876,7 @@ namespace Cpl
                     m_Iterator = it.m_Iterator;
                 }
 
-                std::map<std::string, Node*>::iterator m_Iterator;
+                MapImp::Items::iterator m_Iterator;
 
             };
 
@@ -823,7 +915,7 @@ namespace Cpl
                     m_Iterator = it.m_Iterator;
                 }
 
-                std::map<size_t, Node*>::const_iterator m_Iterator;
+                std::vector<Node*>::const_iterator m_Iterator;
 
             };
 
@@ -862,7 +954,7 @@ namespace Cpl
                     m_Iterator = it.m_Iterator;
                 }
 
-                std::map<std::string, Node*>::const_iterator m_Iterator;
+                MapImp::Items::const_iterator m_Iterator;
             };
 
             CPL_INLINE String ErrorInvalidCharacter() { return "Invalid character found."; }
@@ -876,6 +968,7 @@ namespace Cpl
             CPL_INLINE String ErrorIncorrectOffset() { return "Incorrect offset."; }
             CPL_INLINE String ErrorSequenceError() { return "Error in sequence node."; }
             CPL_INLINE String ErrorCannotOpenFile() { return "Cannot open file."; }
+            CPL_INLINE String ErrorCannotWriteFile() { return "Cannot write file."; }
             CPL_INLINE String ErrorIndentation() { return "Space indentation is less than 2."; }
             CPL_INLINE String ErrorInvalidBlockScalar() { return "Invalid block scalar."; }
             CPL_INLINE String ErrorInvalidQuote() { return "Invalid quote."; }
@@ -979,7 +1072,7 @@ namespace Cpl
             switch (m_Type)
             {
             case SequenceType:
-                return { String(), *(static_cast<Detail::SequenceIteratorImp*>(m_pImp)->m_Iterator->second) };
+                return { Detail::EmptyString(), **(static_cast<Detail::SequenceIteratorImp*>(m_pImp)->m_Iterator) };
                 break;
             case MapType:
                 return { static_cast<Detail::MapIteratorImp*>(m_pImp)->m_Iterator->first,
@@ -1131,7 +1224,7 @@ namespace Cpl
             switch (m_Type)
             {
             case SequenceType:
-                return { String(), *(static_cast<Detail::SequenceConstIteratorImp*>(m_pImp)->m_Iterator->second) };
+                return { Detail::EmptyString(), **(static_cast<Detail::SequenceConstIteratorImp*>(m_pImp)->m_Iterator) };
                 break;
             case MapType:
                 return { static_cast<Detail::MapConstIteratorImp*>(m_pImp)->m_Iterator->first,
@@ -1224,6 +1317,12 @@ namespace Cpl
             *this = value;
         }
 
+        inline Node::Node(std::string&& value) :
+            Node()
+        {
+            *this = std::move(value);
+        }
+
         inline Node::Node(const char* value) :
             Node()
         {
@@ -1333,6 +1432,13 @@ namespace Cpl
             return *this;
         }
 
+        inline Node& Node::operator = (std::string&& value)
+        {
+            ((Detail::NodeImp*)m_pImp)->InitScalar();
+            static_cast<Detail::ScalarImp*>(((Detail::NodeImp*)m_pImp)->m_pImp)->m_Value = std::move(value);
+            return *this;
+        }
+
         inline Node& Node::operator = (const char* value)
         {
             ((Detail::NodeImp*)m_pImp)->InitScalar();
@@ -1455,6 +1561,43 @@ namespace Cpl
 
         //-----------------------------------------------------------------------------------------
 
+        /*
+        * Read-only stream buffer over the caller's data, so parsing from memory doesn't copy the
+        * whole source into a std::string and then into a std::stringstream.
+        */
+        class ReaderBuffer : public std::streambuf
+        {
+        public:
+            ReaderBuffer(const char* data, const size_t size)
+            {
+                char* begin = const_cast<char*>(data);
+                setg(begin, begin, begin + size);
+            }
+
+        protected:
+            virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+            {
+                if ((which & std::ios_base::in) == 0)
+                {
+                    return pos_type(off_type(-1));
+                }
+                char* base = dir == std::ios_base::beg ? eback() : (dir == std::ios_base::cur ? gptr() : egptr());
+                if (off < eback() - base || off > egptr() - base)
+                {
+                    return pos_type(off_type(-1));
+                }
+                setg(eback(), base + off, egptr());
+                return pos_type(off_type(gptr() - eback()));
+            }
+
+            virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which)
+            {
+                return seekoff(off_type(pos), std::ios_base::beg, which);
+            }
+        };
+
+        //-----------------------------------------------------------------------------------------
+
         class ReaderLine
         {
         public:
@@ -1532,6 +1675,7 @@ namespace Cpl
         {
         public:
             ParseImp()
+                : m_NextLineNo(0)
             {
             }
 
@@ -1557,6 +1701,75 @@ namespace Cpl
                 }
             }
 
+            bool ParseNext(Node& root, std::istream& stream, size_t& lineNo, bool& started)
+            {
+                root.Clear();
+                ClearLines();
+                bool opened = started, ended = false;
+                started = false;
+                if (opened && m_NextLine.size())
+                {
+                    AddLine(m_NextLine, m_NextLineNo);
+                }
+                m_NextLine.clear();
+                std::string line;
+                while (!ended && std::getline(stream, line))
+                {
+                    lineNo++;
+                    RemoveComment(line);
+                    const size_t end = line.find_last_not_of(" \t\r");
+                    if (end != std::string::npos && end >= 2 && line.compare(0, 3, "---") == 0 && 
+                        (end == 2 || line[3] == ' ' || line[3] == '\t'))
+                    {
+                        if (opened || m_Lines.size())
+                        {
+                            started = true;
+                            ended = true;
+                        }
+                        opened = true;
+                        if (end > 2)
+                        {
+                            // Content after "---" belongs to the document the marker starts.
+                            line.replace(0, 3, 3, ' ');
+                            if (ended)
+                            {
+                                m_NextLine.swap(line);
+                                m_NextLineNo = lineNo;
+                            }
+                            else
+                            {
+                                AddLine(line, lineNo);
+                            }
+                        }
+                    }
+                    else if (end == 2 && line.compare(0, 3, "...") == 0)
+                    {
+                        ended = opened || m_Lines.size();
+                    }
+                    else
+                    {
+                        AddLine(line, lineNo);
+                    }
+                }
+                if (!ended && m_Lines.empty())
+                {
+                    // End of stream, a trailing "---" doesn't start a document.
+                    return false;
+                }
+                try
+                {
+                    PostProcessLines();
+                    ParseRoot(root);
+                }
+                catch (const Exception&)
+                {
+                    root.Clear();
+                    throw;
+                }
+                ClearLines();
+                return true;
+            }
+
         private:
 
             ParseImp(const ParseImp& copy)
@@ -1568,7 +1781,6 @@ namespace Cpl
                 std::string     line = "";
                 size_t          lineNo = 0;
                 bool            documentStartFound = false;
-                bool            foundFirstNotEmpty = false;
                 std::streampos  streamPos = 0;
 
                 // Read all lines, as long as the stream is ok.
@@ -1579,12 +1791,7 @@ namespace Cpl
                     std::getline(stream, line);
                     lineNo++;
 
-                    // Remove comment
-                    const size_t commentPos = FindNotCited(line, '#');
-                    if (commentPos != std::string::npos)
-                    {
-                        line.resize(commentPos);
-                    }
+                    RemoveComment(line);
 
                     // Start of document.
                     if (documentStartFound == false && line == "---")
@@ -1606,61 +1813,68 @@ namespace Cpl
                         break;
                     }
 
-                    // Remove trailing return.
-                    if (line.size())
+                    AddLine(line, lineNo);
+                }
+            }
+
+            static void RemoveComment(std::string& line)
+            {
+                const size_t commentPos = FindNotCited(line, '#');
+                if (commentPos != std::string::npos)
+                {
+                    line.resize(commentPos);
+                }
+            }
+
+            void AddLine(std::string& line, size_t lineNo)
+            {
+                // Remove trailing return.
+                if (line.size())
+                {
+                    if (line[line.size() - 1] == '\r')
                     {
-                        if (line[line.size() - 1] == '\r')
-                        {
-                            line.resize(line.size() - 1);
-                        }
+                        line.resize(line.size() - 1);
                     }
+                }
 
-                    // Validate characters.
-                    for (size_t i = 0; i < line.size(); i++)
+                // Validate characters.
+                for (size_t i = 0; i < line.size(); i++)
+                {
+                    if (line[i] != '\t' && (line[i] < 32 || line[i] > 125))
                     {
-                        if (line[i] != '\t' && (line[i] < 32 || line[i] > 125))
-                        {
-                            throw ParsingException(ExceptionMessage(Detail::ErrorInvalidCharacter(), lineNo, i + 1));
-                        }
+                        throw ParsingException(ExceptionMessage(Detail::ErrorInvalidCharacter(), lineNo, i + 1));
                     }
+                }
 
-                    // Validate tabs
-                    const size_t firstTabPos = line.find_first_of('\t');
-                    size_t       startOffset = line.find_first_not_of(" \t");
+                // Validate tabs
+                const size_t firstTabPos = line.find_first_of('\t');
+                size_t       startOffset = line.find_first_not_of(" \t");
 
-                    // Make sure no tabs are in the very front.
-                    if (startOffset != std::string::npos)
-                    {
-                        if (firstTabPos < startOffset)
-                        {
-                            throw ParsingException(ExceptionMessage(Detail::ErrorTabInOffset(), lineNo, firstTabPos));
-                        }
-
-                        // Remove front spaces.
-                        line = line.substr(startOffset);
-                    }
-                    else
+                // Make sure no tabs are in the very front.
+                if (startOffset != std::string::npos)
+                {
+                    if (firstTabPos < startOffset)
                     {
-                        startOffset = 0;
-                        line = "";
+                        throw ParsingException(ExceptionMessage(Detail::ErrorTabInOffset(), lineNo, firstTabPos));
                     }
 
-                    // Add line.
-                    if (foundFirstNotEmpty == false)
-                    {
-                        if (line.size())
-                        {
-                            foundFirstNotEmpty = true;
-                        }
-                        else
-                        {
-                            continue;
-                        }
-                    }
+                    // Remove front spaces.
+                    line.erase(0, startOffset);
+                }
+                else
+                {
+                    startOffset = 0;
+                    line.clear();
+                }
 
-                    ReaderLine* pLine = new ReaderLine(line, lineNo, startOffset);
-                    m_Lines.push_back(pLine);
+                // Skip leading empty lines.
+                if (m_Lines.empty() && line.empty())
+                {
+                    return;
                 }
+
+                ReaderLine* pLine = new ReaderLine(line, lineNo, startOffset);
+                m_Lines.push_back(pLine);
             }
 
             void PostProcessLines()
@@ -2030,7 +2244,7 @@ namespace Cpl
                         }
                         else
                         {
-                            data += pLine->Data.substr(0, endOffset + 1);
+                            data.append(pLine->Data, 0, endOffset + 1);
                         }
 
                         // Move to next line
@@ -2127,10 +2341,10 @@ namespace Cpl
 
                 if (data.size() && (data[0] == '"' || data[0] == '\''))
                 {
-                    data = data.substr(1, data.size() - 2);
+                    data.erase(data.size() - 1).erase(0, 1);
                 }
 
-                node = data;
+                node = std::move(data);
             }
 
             void Print()
@@ -2310,6 +2524,8 @@ namespace Cpl
             }
 
             std::list<ReaderLine*> m_Lines;    ///< List of lines.
+            std::string m_NextLine;             ///< Content of "--- value" marker line which starts the next document.
+            size_t m_NextLineNo;                ///< Number of this line.
 
         };
 
@@ -2353,14 +2569,60 @@ namespace Cpl
 
         inline void Parse(Node& root, const std::string& string)
         {
-            std::stringstream ss(string);
-            Parse(root, ss);
+            Parse(root, string.c_str(), string.size());
         }
 
         inline void Parse(Node& root, const char* buffer, const size_t size)
         {
-            std::stringstream ss(std::string(buffer, size));
-            Parse(root, ss);
+            ReaderBuffer buf(buffer, size);
+            std::istream stream(&buf);
+            Parse(root, stream);
+        }
+
+        //-----------------------------------------------------------------------------------------
+
+        inline DocumentReader::DocumentReader(std::istream& stream)
+            : m_Stream(stream)
+            , m_pImp(new ParseImp)
+            , m_LineNo(0)
+            , m_Count(0)
+            , m_Started(false)
+        {
+        }
+
+        inline DocumentReader::DocumentReader(const char* filename)
+            : m_File(filename, std::ifstream::binary)
+            , m_Stream(m_File)
+            , m_pImp(nullptr)
+            , m_LineNo(0)
+            , m_Count(0)
+            , m_Started(false)
+        {
+            if (m_File.is_open() == false)
+            {
+                throw OperationException(Detail::ErrorCannotOpenFile());
+            }
+            m_pImp = new ParseImp;
+        }
+
+        inline DocumentReader::~DocumentReader()
+        {
+            delete m_pImp;
+        }
+
+        inline bool DocumentReader::Next(Node& root)
+        {
+            if (m_pImp->ParseNext(root, m_Stream, m_LineNo, m_Started))
+            {
+                m_Count++;
+                return true;
+            }
+            return false;
+        }
+
+        inline size_t DocumentReader::Count() const
+        {
+            return m_Count;
         }
 
         //-----------------------------------------------------------------------------------------
@@ -2378,21 +2640,6 @@ namespace Cpl
 
         //-----------------------------------------------------------------------------------------
 
-        inline void Serialize(const Node& root, const char* filename, const SerializeConfig& config)
-        {
-            std::stringstream stream;
-            Serialize(root, stream, config);
-
-            std::ofstream f(filename);
-            if (f.is_open() == false)
-            {
-                throw OperationException(Detail::ErrorCannotOpenFile());
-            }
-
-            f.write(stream.str().c_str(), stream.str().size());
-            f.close();
-        }
-
         inline size_t LineFolding(const std::string& input, std::vector<std::string>& folded, const size_t maxLength)
         {
             folded.clear();
@@ -2432,7 +2679,94 @@ namespace Cpl
             return folded.size();
         }
 
-        inline void SerializeLoop(const Node& node, std::ostream& stream, bool useLevel, const size_t level, const SerializeConfig& config)
+        namespace Detail
+        {
+            class Writer : public OutputBuffer<char>
+            {
+            public:
+                typedef std::pair<size_t, size_t> Range;
+                typedef std::vector<Range> Ranges;
+
+                Writer(FlushPtr flush, void* userData) :
+                    OutputBuffer<char>(flush, userData)
+                {
+                }
+
+                using OutputBuffer<char>::Write;
+
+                void Write(const std::string& data, size_t offset = 0, size_t size = std::string::npos)
+                {
+                    Write(data.data() + offset, std::min(size, data.size() - offset));
+                }
+
+                Ranges& Lines()
+                {
+                    return m_Lines;
+                }
+
+            private:
+                Ranges m_Lines;             ///< Scratch for lines of current scalar.
+            };
+
+            inline void SplitLines(const std::string& value, Writer::Ranges& lines)
+            {
+                lines.clear();
+                size_t start = 0;
+                for (size_t end = value.find('\n'); end != std::string::npos; end = value.find('\n', start))
+                {
+                    lines.push_back(Writer::Range(start, end - start));
+                    start = end + 1;
+                }
+                lines.push_back(Writer::Range(start, value.size() - start));
+            }
+
+            // The same folding as LineFolding, but the lines are ranges of the input.
+            inline size_t FoldLine(const std::string& input, size_t offset, size_t size, Writer::Ranges& folded, const size_t maxLength)
+            {
+                folded.clear();
+                const size_t end = offset + size;
+                size_t currentPos = 0;
+                size_t lastPos = offset;
+                size_t spacePos = std::string::npos;
+                while (currentPos < end)
+                {
+                    currentPos = lastPos + maxLength;
+                    if (currentPos < end)
+                    {
+                        spacePos = input.find(' ', currentPos);
+                        if (spacePos >= end)
+                        {
+                            spacePos = std::string::npos;
+                        }
+                    }
+                    if (spacePos == std::string::npos || currentPos >= end)
+                    {
+                        if (lastPos < end)
+                        {
+                            folded.push_back(Writer::Range(lastPos, end - lastPos));
+                        }
+                        return folded.size();
+                    }
+                    folded.push_back(Writer::Range(lastPos, spacePos - lastPos));
+                    lastPos = spacePos + 1;
+                }
+                return folded.size();
+            }
+
+            inline void WriteEscapedKey(Writer& writer, const std::string& key)
+            {
+                for (size_t i = 0; i < key.size(); ++i)
+                {
+                    if (key[i] == '\\' || key[i] == '"')
+                    {
+                        writer.Write('\\');
+                    }
+                    writer.Write(key[i]);
+                }
+            }
+        }
+
+        inline void SerializeLoop(const Node& node, Detail::Writer& writer, bool useLevel, const size_t level, const SerializeConfig& config)
         {
             const size_t indention = config.SpaceIndentation;
 
@@ -2447,15 +2781,16 @@ namespace Cpl
                     {
                         continue;
                     }
-                    stream << std::string(level, ' ') << "- ";
+                    writer.Fill(' ', level);
+                    writer.Write("- ", 2);
                     useLevel = false;
                     if (value.IsSequence() || (value.IsMap() && config.SequenceMapNewline == true))
                     {
                         useLevel = true;
-                        stream << "\n";
+                        writer.Write('\n');
                     }
 
-                    SerializeLoop(value, stream, useLevel, level + 2, config);
+                    SerializeLoop(value, writer, useLevel, level + 2, config);
                 }
 
             }
@@ -2473,18 +2808,21 @@ namespace Cpl
 
                     if (useLevel || count > 0)
                     {
-                        stream << std::string(level, ' ');
+                        writer.Fill(' ', level);
                     }
 
-                    std::string key = (*it).first;
-                    AddEscapeTokens(key, "\\\"");
+                    // Escaping adds only backslashes, so citing does not depend on it.
+                    const std::string& key = (*it).first;
                     if (ShouldBeCited(key))
                     {
-                        stream << "\"" << key << "\"" << ": ";
+                        writer.Write('"');
+                        Detail::WriteEscapedKey(writer, key);
+                        writer.Write("\": ", 3);
                     }
                     else
                     {
-                        stream << key << ": ";
+                        Detail::WriteEscapedKey(writer, key);
+                        writer.Write(": ", 2);
                     }
 
 
@@ -2492,10 +2830,10 @@ namespace Cpl
                     if (value.IsScalar() == false || (value.IsScalar() && config.MapScalarNewline))
                     {
                         useLevel = true;
-                        stream << "\n";
+                        writer.Write('\n');
                     }
 
-                    SerializeLoop(value, stream, useLevel, level + indention, config);
+                    SerializeLoop(value, writer, useLevel, level + indention, config);
 
                     useLevel = true;
                     count++;
@@ -2505,28 +2843,21 @@ namespace Cpl
             break;
             case Node::ScalarType:
             {
-                const std::string value = node.As<std::string>();
+                const std::string& value = node.AsString();
 
                 // Empty scalar
                 if (value.size() == 0)
                 {
-                    stream << "\n";
+                    writer.Write('\n');
                     break;
                 }
 
                 // Get lines of scalar.
-                std::string line = "";
-                std::vector<std::string> lines;
-                std::istringstream iss(value);
-                while (iss.eof() == false)
-                {
-                    std::getline(iss, line);
-                    lines.push_back(line);
-                }
+                Detail::Writer::Ranges& lines = writer.Lines();
+                Detail::SplitLines(value, lines);
 
                 // Block scalar
-                const std::string& lastLine = lines.back();
-                const bool endNewline = lastLine.size() == 0;
+                const bool endNewline = lines.back().second == 0;
                 if (endNewline)
                 {
                     lines.pop_back();
@@ -2535,44 +2866,49 @@ namespace Cpl
                 // Literal
                 if (lines.size() > 1)
                 {
-                    stream << "|";
+                    writer.Write('|');
                 }
                 // Folded/plain
                 else
                 {
-                    const std::string frontLine = lines.front();
-                    if (config.ScalarMaxLength == 0 || lines.front().size() <= config.ScalarMaxLength ||
-                        LineFolding(frontLine, lines, config.ScalarMaxLength) == 1)
+                    const Detail::Writer::Range frontLine = lines.front();
+                    if (config.ScalarMaxLength == 0 || frontLine.second <= config.ScalarMaxLength ||
+                        Detail::FoldLine(value, frontLine.first, frontLine.second, lines, config.ScalarMaxLength) == 1)
                     {
                         if (useLevel)
                         {
-                            stream << std::string(level, ' ');
+                            writer.Fill(' ', level);
                         }
 
                         if (ShouldBeCited(value))
                         {
-                            stream << "\"" << value << "\"\n";
+                            writer.Write('"');
+                            writer.Write(value);
+                            writer.Write("\"\n", 2);
                             break;
                         }
-                        stream << value << "\n";
+                        writer.Write(value);
+                        writer.Write('\n');
                         break;
                     }
                     else
                     {
-                        stream << ">";
+                        writer.Write('>');
                     }
                 }
 
                 if (endNewline == false)
                 {
-                    stream << "-";
+                    writer.Write('-');
                 }
-                stream << "\n";
+                writer.Write('\n');
 
 
                 for (auto it = lines.begin(); it != lines.end(); it++)
                 {
-                    stream << std::string(level, ' ') << (*it) << "\n";
+                    writer.Fill(' ', level);
+                    writer.Write(value, it->first, it->second);
+                    writer.Write('\n');
                 }
             }
             break;
@@ -2582,21 +2918,56 @@ namespace Cpl
             }
         }
 
-        inline void Serialize(const Node& root, std::ostream& stream, const SerializeConfig& config)
+        inline void SerializeLoop(const Node& node, std::ostream& stream, bool useLevel, const size_t level, const SerializeConfig& config)
+        {
+            Detail::Writer writer(FlushToStream<char>, &stream);
+            SerializeLoop(node, writer, useLevel, level, config);
+        }
+
+        inline void Serialize(const Node& root, Detail::Writer& writer, const SerializeConfig& config)
         {
             if (config.SpaceIndentation < 2)
             {
                 throw OperationException(Detail::ErrorIndentation());
             }
 
-            SerializeLoop(root, stream, false, 0, config);
+            SerializeLoop(root, writer, false, 0, config);
+        }
+
+        inline size_t Serialize(const Node& root, const char* filename, const SerializeConfig& config)
+        {
+            std::ofstream f;
+            f.rdbuf()->pubsetbuf(0, 0);
+            f.open(filename);
+            if (f.is_open() == false)
+            {
+                throw OperationException(Detail::ErrorCannotOpenFile());
+            }
+
+            Detail::Writer writer(FlushToStream<char>, &f);
+            Serialize(root, writer, config);
+            writer.Flush();
+            f.close();
+            if (f.fail())
+            {
+                throw OperationException(Detail::ErrorCannotWriteFile());
+            }
+            return writer.Total();
+        }
+
+        inline void Serialize(const Node& root, std::ostream& stream, const SerializeConfig& config)
+        {
+            Detail::Writer writer(FlushToStream<char>, &stream);
+            Serialize(root, writer, config);
         }
 
         inline void Serialize(const Node& root, std::string& string, const SerializeConfig& config)
         {
-            std::stringstream stream;
-            Serialize(root, stream, config);
-            string = stream.str();
+            std::string result;
+            Detail::Writer writer(FlushToString<char>, &result);
+            Serialize(root, writer, config);
+            writer.Flush();
+            string.swap(result);
         }
 
         //-----------------------------------------------------------------------------------------
@@ -2720,7 +3091,6 @@ namespace Cpl
                 if (input.size() == 1)
                     return false;
                 token = input[0];
-                searchPos = 1;
             }
             while (searchPos != std::string::npos && searchPos < input.size() - 1)
             {
@@ -27,9 +27,13 @@
 #define CPL_IMPLEMENT
 #include "Cpl/Log.h"
 #include "Cpl/Performance.h"
+#include "Cpl/Benchmark.h"
 
 #include "Test/Test.h"
 
+#include <atomic>
+#include <condition_variable>
+
 namespace Test
 {
     typedef bool(*TestPtr)();
@@ -38,10 +42,12 @@ namespace Test
     {
         String name;
         TestPtr test;
+        bool serial;
 
-        Group(const String& n, const TestPtr& t)
+        Group(const String& n, const TestPtr& t, bool s = false)
             : name(n)
             , test(t)
+            , serial(s)
         {
         }
     };
@@ -53,6 +59,11 @@ namespace Test
     bool name##AddToList(){ g_groups.push_back(Group(#name, name##Test)); return true; } \
     bool name##AtList = name##AddToList();
 
+#define TEST_ADD_SERIAL(name) \
+    bool name##Test(); \
+    bool name##AddToList(){ g_groups.push_back(Group(#name, name##Test, true)); return true; } \
+    bool name##AtList = name##AddToList();
+
     TEST_ADD(LogCallback);
     TEST_ADD(LogCallbackRaw);
     TEST_ADD(LogDateTime);
@@ -67,6 +78,7 @@ namespace Test
     TEST_ADD(SeparateStringMulti);
     TEST_ADD(TimeToStr);
     TEST_ADD(ToStr);
+    TEST_ADD(ToVal);
 
     TEST_ADD(PolygonHasPoint);
     TEST_ADD(PolygonOverlapsRectangle);
@@ -79,41 +91,137 @@ namespace Test
     TEST_ADD(ParamEnum);
     TEST_ADD(ParamMap);
     TEST_ADD(ParamMapBug);
+    TEST_ADD(ParamEnumCase);
     TEST_ADD(ParamLimited);
+    TEST_ADD(ParamEntities);
     TEST_ADD(ParamTemplate);
+    TEST_ADD(ParamSchema);
+    TEST_ADD(ParamPatch);
+    TEST_ADD(ParamArray);
+    TEST_ADD_SERIAL(ParamParallelLoad);
+    TEST_ADD(ParamLazy);
 
     TEST_ADD(ParamVectorV2);
     TEST_ADD(ParamMapV2);
+    TEST_ADD(ParamSnapshot);
+    TEST_ADD(ParamWatcher);
 
     TEST_ADD(Prop);
 
-    TEST_ADD(PerformanceSimple);
-    TEST_ADD(PerformanceStdThread);
-    TEST_ADD(PerformanceClear);
+    TEST_ADD_SERIAL(PerformanceSimple);
+    TEST_ADD_SERIAL(PerformanceStdThread);
+    TEST_ADD_SERIAL(PerformanceClear);
+    TEST_ADD(PerformanceAllocation);
+    TEST_ADD(PerformanceSlow);
 #if defined(CPL_TEST_NORETURN)
-    TEST_ADD(PerformanceNoReturn);
+    TEST_ADD_SERIAL(PerformanceNoReturn);
 #endif
 #if defined(__linux__)
-    TEST_ADD(PerformancePthread);
+    TEST_ADD_SERIAL(PerformancePthread);
 #endif
 
     TEST_ADD(TableSimple);
     TEST_ADD(TableSortable);
 
     TEST_ADD(YamlSimple);
+    TEST_ADD(YamlSerialize);
+    TEST_ADD(YamlNode);
+    TEST_ADD(YamlDocumentReader);
     TEST_ADD(YamlParam);
 
+    TEST_ADD(JsonParse);
+    TEST_ADD(JsonParam);
+
     TEST_ADD(XmlAllocateString);
-    TEST_ADD(DoFileModify);
-    TEST_ADD(DoFileExistance);
-    TEST_ADD(DoFileInfo);
+    TEST_ADD(XmlReader);
+    TEST_ADD(XmlPrint);
+    TEST_ADD(XmlParseParallel);
+    TEST_ADD(XmlPath);
+    TEST_ADD(XmlInternNames);
+    TEST_ADD_SERIAL(DoFileModify);
+    TEST_ADD_SERIAL(DoFileExistance);
+    TEST_ADD_SERIAL(DoFileInfo);
+
+    TEST_ADD(BenchmarkSimple);
+    TEST_ADD(BenchmarkCompare);
+
+#if defined(CPL_PERF_ENABLE)
+    typedef Cpl::BenchmarkPtr BenchPtr;
+
+    struct Bench
+    {
+        String name;
+        BenchPtr bench;
+
+        Bench(const String& n, const BenchPtr& b)
+            : name(n)
+            , bench(b)
+        {
+        }
+    };
+    typedef std::vector<Bench> Benches;
+    Benches g_benches;
+
+#define BENCH_ADD(name) \
+    void name##Bench(Cpl::BenchmarkState& state); \
+    bool name##AddToBenchList(){ g_benches.push_back(Bench(#name, name##Bench)); return true; } \
+    bool name##AtBenchList = name##AddToBenchList();
+
+    BENCH_ADD(ToStrInt);
+    BENCH_ADD(ToStrDouble);
+    BENCH_ADD(ToValInt);
+    BENCH_ADD(ToValDouble);
+    BENCH_ADD(ToValEnum);
+    BENCH_ADD(ToStrEnum);
+
+    BENCH_ADD(XmlParse);
+    BENCH_ADD(XmlParseValuesOnly);
+    BENCH_ADD(XmlParseInternNames);
+    BENCH_ADD(XmlParseLarge);
+    BENCH_ADD(XmlParseParallel);
+    BENCH_ADD(XmlPath);
+    BENCH_ADD(XmlPathInterned);
+    BENCH_ADD(XmlPathManual);
+    BENCH_ADD(XmlPrint);
+    BENCH_ADD(XmlPrintIterator);
+    BENCH_ADD(XmlPrintStream);
+    BENCH_ADD(XmlPrintString);
+
+    BENCH_ADD(YamlParse);
+    BENCH_ADD(YamlSerialize);
+    BENCH_ADD(YamlSerializeFile);
+    BENCH_ADD(YamlNodeAccess);
+    BENCH_ADD(YamlDocumentReader);
+
+    BENCH_ADD(JsonParse);
+
+    BENCH_ADD(ParamLoadXml);
+    BENCH_ADD(ParamLoadYaml);
+    BENCH_ADD(ParamSaveXml);
+    BENCH_ADD(ParamSaveYaml);
+    BENCH_ADD(ParamLoadJson);
+    BENCH_ADD(ParamSaveJson);
+    BENCH_ADD(ParamLoadLarge);
+    BENCH_ADD(ParamLoadLargeParallel);
+    BENCH_ADD(ParamLoadLargeLazy);
+    BENCH_ADD(ParamArrayLoadValue);
+    BENCH_ADD(ParamArrayLoadText);
+    BENCH_ADD(ParamArrayLoadBase64);
+    BENCH_ADD(ParamCopy);
+
+    BENCH_ADD(LogWrite);
+#endif
 
     struct Options : public Cpl::ArgsParser
     {
-        bool help;
+        bool help, benchmark;
         Log::Level logLevel;
-        String logFile;
+        String logFile, benchOutput, benchSave, benchBaseline;
+        size_t threads;
         Strings include, exclude;
+        double benchTime, benchWarmup, benchThreshold, benchAlpha;
+        size_t benchRepeats;
+        int benchCore;
 
         Options(int argc, char* argv[])
             : Cpl::ArgsParser(argc, argv, true)
@@ -123,16 +231,27 @@ namespace Test
             logFile = GetArg2("-lf", "--logFile", "", false);
             include = GetArgs("-i", Strings(), false);
             exclude = GetArgs("-e", Strings(), false);
+            threads = std::max(Cpl::ToVal<size_t>(GetArg2("-j", "--jobs", "1", false)), size_t(1));
+            benchmark = HasArg("-bm", "--benchmark");
+            benchTime = Cpl::ToVal<double>(GetArg2("-bt", "--benchTime", "0.05", false));
+            benchWarmup = Cpl::ToVal<double>(GetArg2("-bw", "--benchWarmup", "0.02", false));
+            benchRepeats = Cpl::ToVal<size_t>(GetArg2("-br", "--benchRepeats", "5", false));
+            benchCore = Cpl::ToVal<int>(GetArg2("-bc", "--benchCore", "-1", false));
+            benchOutput = GetArg2("-bo", "--benchOutput", "", false);
+            benchSave = GetArg2("-bs", "--benchSave", "", false);
+            benchBaseline = GetArg2("-bb", "--benchBaseline", "", false);
+            benchThreshold = Cpl::ToVal<double>(GetArg2("-bl", "--benchLimit", "10.0", false));
+            benchAlpha = Cpl::ToVal<double>(GetArg2("-ba", "--benchAlpha", "0.05", false));
         }
 
-        bool Required(const Group& group)
+        bool Required(const String& name) const
         {
             bool required = include.empty();
             for (size_t i = 0; i < include.size() && !required; ++i)
-                if (group.name.find(include[i]) != std::string::npos)
+                if (name.find(include[i]) != std::string::npos)
                     required = true;
             for (size_t i = 0; i < exclude.size() && required; ++i)
-                if (group.name.find(exclude[i]) != std::string::npos)
+                if (name.find(exclude[i]) != std::string::npos)
                     required = false;
             return required;
         }
@@ -146,20 +265,48 @@ namespace Test
         std::cout << " -e=test      - exclude test filter." << std::endl << std::endl;
         std::cout << " -ll=1        - a log level." << std::endl << std::endl;
         std::cout << " -lf=test.log - a log file name." << std::endl << std::endl;
+        std::cout << " -j=4         - a number of threads to run tests in parallel." << std::endl << std::endl;
+        std::cout << " -bm          - to run benchmarks instead of tests." << std::endl << std::endl;
+        std::cout << " -bt=0.05     - a minimal time of benchmark repetition (in seconds)." << std::endl << std::endl;
+        std::cout << " -bw=0.02     - a benchmark warm-up time (in seconds)." << std::endl << std::endl;
+        std::cout << " -br=5        - a number of benchmark repetitions." << std::endl << std::endl;
+        std::cout << " -bc=0        - a CPU core to pin benchmark thread (-1 - to disable pinning)." << std::endl << std::endl;
+        std::cout << " -bo=bench    - a base name of benchmark report files (.txt, .html and .json)." << std::endl << std::endl;
+        std::cout << " -bs=base.xml - a file to save benchmark results as a baseline." << std::endl << std::endl;
+        std::cout << " -bb=base.xml - a baseline file to compare benchmark results with." << std::endl << std::endl;
+        std::cout << " -bl=10.0     - a slowdown limit (in percents) to report a benchmark regression." << std::endl << std::endl;
+        std::cout << " -ba=0.05     - a significance level of benchmark comparison." << std::endl << std::endl;
         std::cout << " -h or -?     - to print this help message." << std::endl << std::endl;
         return 0;
     }
 
+    bool RunTest(const Group& group, double& time)
+    {
+#if defined(CPL_PERF_ENABLE)
+        Cpl::PerformanceMeasurer pm(group.name);
+        pm.Enter();
+        bool result = group.test();
+        pm.Leave();
+        time = pm.Total();
+#else
+        double start = Cpl::Time();
+        bool result = group.test();
+        time = (Cpl::Time() - start) * 1000.0;
+#endif
+        return result;
+    }
+
     int MakeTests(const Groups& groups, const Options& options)
     {
         for (size_t t = 0; t < groups.size(); ++t)
         {
             const Group& group = groups[t];
             CPL_LOG_SS(Info, group.name << "Test is started :");
-            bool result = group.test();
+            double time = 0;
+            bool result = RunTest(group, time);
             if (result)
             {
-                CPL_LOG_SS(Info, group.name << "Test is OK." << std::endl);
+                CPL_LOG_SS(Info, group.name << "Test is OK (" << Cpl::ToStr(time, 1) << " ms)." << std::endl);
             }
             else
             {
@@ -170,6 +317,264 @@ namespace Test
         CPL_LOG_SS(Info, "ALL TESTS ARE FINISHED SUCCESSFULLY!" << std::endl);
         return 0;
     }
+
+    //-------------------------------------------------------------------------------------------------
+
+    typedef std::vector<std::pair<Log::Level, String>> Messages;
+
+    struct Result
+    {
+        bool done, result;
+        double time;
+        Messages messages;
+
+        Result()
+            : done(false)
+            , result(false)
+            , time(0)
+        {
+        }
+    };
+    typedef std::vector<Result> Results;
+
+    /*
+    * Log contexts of parallel tests: the main thread replays captured messages in MainLogContext,
+    * every test runs in its own context, threads started by tests have the default context (0).
+    * Messages of such threads can't be attributed to a test and are replayed with a '[no test]' tag.
+    */
+    const int MainLogContext = 1;
+
+    CPL_INLINE int TestLogContext(size_t index)
+    {
+        return int(index) + 2;
+    }
+
+    struct Capture
+    {
+        std::mutex mutex;
+        Messages messages;
+    };
+
+    static void CaptureLog(Log::Level level, const char* message, void* userData)
+    {
+        ((Messages*)userData)->push_back(std::make_pair(level, String(message)));
+    }
+
+    static void CaptureOrphanLog(Log::Level level, const char* message, void* userData)
+    {
+        Capture* capture = (Capture*)userData;
+        std::lock_guard<std::mutex> lock(capture->mutex);
+        capture->messages.push_back(std::make_pair(level, String(message)));
+    }
+
+    static void ReplayLog(const Messages& messages, const String& prefix = String())
+    {
+        for (size_t m = 0; m < messages.size(); ++m)
+            Log::Global().Write(messages[m].first, prefix + messages[m].second);
+    }
+
+    static void ReplayOrphanLog(Capture& orphans)
+    {
+        Messages messages;
+        {
+            std::lock_guard<std::mutex> lock(orphans.mutex);
+            messages.swap(orphans.messages);
+        }
+        ReplayLog(messages, "[no test] ");
+    }
+
+    /*
+    * Serial tests change process-wide state, so they run alone: a serial test waits until running tests are finished
+    * and other tests wait until it is finished.
+    */
+    class TestGate
+    {
+    public:
+        TestGate()
+            : _running(0)
+            , _exclusive(false)
+        {
+        }
+
+        void Enter(bool serial)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _changed.wait(lock, [this] { return !_exclusive; });
+            if (serial)
+            {
+                _exclusive = true;
+                _changed.wait(lock, [this] { return _running == 0; });
+            }
+            else
+                _running++;
+        }
+
+        void Leave(bool serial)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (serial)
+                    _exclusive = false;
+                else
+                    _running--;
+            }
+            _changed.notify_all();
+        }
+
+    private:
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        size_t _running;
+        bool _exclusive;
+    };
+
+    int MakeTestsParallel(const Groups& groups, const Options& options)
+    {
+        Results results(groups.size());
+        std::atomic<size_t> next(0);
+        std::atomic<bool> stop(false);
+        std::mutex mutex;
+        TestGate gate;
+        std::condition_variable done;
+        Capture orphans;
+
+        CPL_LOG_SS(Info, "Run " << groups.size() << " tests in " << options.threads << " threads." << std::endl);
+        int orphanId = Log::Global().AddContextWriter(options.logLevel, CaptureOrphanLog, &orphans, 0);
+        std::vector<std::thread> threads;
+        for (size_t i = 0, n = std::min(options.threads, groups.size()); i < n; ++i)
+        {
+            threads.push_back(std::thread([&]()
+            {
+                for (size_t t = next++; t < groups.size() && !stop; t = next++)
+                {
+                    const Group& group = groups[t];
+                    Result& result = results[t];
+                    int id = Log::Global().AddContextWriter(options.logLevel, CaptureLog, &result.messages, TestLogContext(t));
+                    Log::ThreadContext() = TestLogContext(t);
+                    gate.Enter(group.serial);
+                    result.result = RunTest(group, result.time);
+                    gate.Leave(group.serial);
+                    Log::ThreadContext() = 0;
+                    Log::Global().RemoveWriter(id);
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        result.done = true;
+                    }
+                    done.notify_all();
+                }
+            }));
+        }
+
+        int status = 0;
+        for (size_t t = 0; t < groups.size() && status == 0; ++t)
+        {
+            const Group& group = groups[t];
+            const Result& result = results[t];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [&result] { return result.done; });
+            }
+            CPL_LOG_SS(Info, group.name << "Test is started :");
+            ReplayLog(result.messages);
+            if (result.result)
+            {
+                CPL_LOG_SS(Info, group.name << "Test is OK (" << Cpl::ToStr(result.time, 1) << " ms)." << std::endl);
+            }
+            else
+            {
+                CPL_LOG_SS(Error, group.name << "Test has errors. TEST EXECUTION IS TERMINATED!" << std::endl);
+                stop = true;
+                status = 1;
+            }
+            ReplayOrphanLog(orphans);
+        }
+        for (size_t i = 0; i < threads.size(); ++i)
+            threads[i].join();
+        Log::Global().RemoveWriter(orphanId);
+        ReplayOrphanLog(orphans);
+        if (status == 0)
+            CPL_LOG_SS(Info, "ALL TESTS ARE FINISHED SUCCESSFULLY!" << std::endl);
+        return status;
+    }
+
+#if defined(CPL_PERF_ENABLE)
+    int MakeBenchmarks(const Options& options)
+    {
+        Cpl::BenchmarkOptions benchOptions(options.benchTime, options.benchWarmup, options.benchRepeats, options.benchCore);
+        if (options.benchCore >= 0 && !Cpl::PinThread(options.benchCore))
+            CPL_LOG_SS(Warning, "Can't pin benchmark thread to CPU core " << options.benchCore << " !");
+        Cpl::BenchmarkResults results;
+        for (size_t b = 0; b < g_benches.size(); ++b)
+        {
+            const Bench& bench = g_benches[b];
+            if (!options.Required(bench.name))
+                continue;
+            CPL_LOG_SS(Info, bench.name << "Bench is started :");
+            results.push_back(Cpl::RunBenchmark(bench.name, bench.bench, benchOptions));
+            CPL_LOG_SS(Info, bench.name << "Bench : " << Cpl::ToStr(results.back().median, 1) << " ns.");
+        }
+        if (results.empty())
+        {
+            CPL_LOG_SS(Error, "There are not any suitable benchmarks for current filters!");
+            return 1;
+        }
+        Cpl::Table table = Cpl::BenchmarkTable(results);
+        CPL_LOG_SS(Info, "Benchmark report:" << std::endl << std::endl << table.GenerateText());
+        if (!options.benchOutput.empty())
+        {
+            std::ofstream ofsText(options.benchOutput + ".txt");
+            std::ofstream ofsHtml(options.benchOutput + ".html");
+            std::ofstream ofsJson(options.benchOutput + ".json");
+            if (!ofsText.is_open() || !ofsHtml.is_open() || !ofsJson.is_open())
+            {
+                CPL_LOG_SS(Error, "Can't write benchmark report to '" << options.benchOutput << "' !");
+                return 1;
+            }
+            ofsText << table.GenerateText();
+            ofsHtml << "<html><body>" << std::endl;
+            ofsHtml << table.GenerateHtml(0, true, true);
+            ofsHtml << "</body></html>" << std::endl;
+            ofsJson << Cpl::BenchmarkJson(results);
+        }
+        if (!options.benchSave.empty() && !Cpl::SaveBenchmarkBaseline(options.benchSave, results))
+        {
+            CPL_LOG_SS(Error, "Can't save benchmark baseline to '" << options.benchSave << "' !");
+            return 1;
+        }
+        if (!options.benchBaseline.empty())
+        {
+            Cpl::BenchmarkResults baseline;
+            if (!Cpl::LoadBenchmarkBaseline(options.benchBaseline, baseline))
+            {
+                CPL_LOG_SS(Error, "Can't load benchmark baseline from '" << options.benchBaseline << "' !");
+                return 1;
+            }
+            Cpl::BenchmarkComparisons comparisons = Cpl::CompareBenchmarks(baseline, results, options.benchThreshold, options.benchAlpha);
+            Cpl::Table compare = Cpl::BenchmarkCompareTable(comparisons);
+            CPL_LOG_SS(Info, "Comparison with baseline '" << options.benchBaseline << "':" << std::endl << std::endl << compare.GenerateText());
+            if (!options.benchOutput.empty())
+            {
+                std::ofstream ofsHtml(options.benchOutput + "_compare.html");
+                if (ofsHtml.is_open())
+                {
+                    ofsHtml << "<html><body>" << std::endl;
+                    ofsHtml << compare.GenerateHtml(0, true, true);
+                    ofsHtml << "</body></html>" << std::endl;
+                }
+            }
+            size_t regressions = 0;
+            for (size_t i = 0; i < comparisons.size(); ++i)
+                if (comparisons[i].regression)
+                    regressions++;
+            if (regressions)
+            {
+                CPL_LOG_SS(Error, "There are " << regressions << " benchmark regressions!");
+                return 1;
+            }
+        }
+        return 0;
+    }
+#endif
 }
 
 int main(int argc, char* argv[])
@@ -179,14 +584,29 @@ int main(int argc, char* argv[])
     if (options.help)
         return Test::PrintHelp();
 
-    Cpl::Log::Global().AddStdWriter(options.logLevel);
-    if(!options.logFile.empty())
-        Cpl::Log::Global().AddFileWriter(options.logLevel, options.logFile);
+    bool parallel = options.threads > 1 && !options.benchmark;
+    int stdWriter = Cpl::Log::Global().AddStdWriter(options.logLevel);
+    if (parallel)
+    {
+        Cpl::Log::ThreadContext() = Test::MainLogContext;
+        Cpl::Log::Global().BindWriterToContext(stdWriter, Test::MainLogContext);
+    }
+    if (!options.logFile.empty())
+    {
+        int fileWriter = Cpl::Log::Global().AddFileWriter(options.logLevel, options.logFile);
+        if (parallel)
+            Cpl::Log::Global().BindWriterToContext(fileWriter, Test::MainLogContext);
+    }
     Cpl::Log::Global().SetFlags(Cpl::Log::BashFlags);
 
+#if defined(CPL_PERF_ENABLE)
+    if (options.benchmark)
+        return Test::MakeBenchmarks(options);
+#endif
+
     Test::Groups groups;
     for (const Test::Group& group : Test::g_groups)
-        if (options.Required(group))
+        if (options.Required(group.name))
             groups.push_back(group);
 
     if (groups.empty())
@@ -205,5 +625,8 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    return Test::MakeTests(groups, options);
+    if (parallel)
+        return Test::MakeTestsParallel(groups, options);
+    else
+        return Test::MakeTests(groups, options);
 }
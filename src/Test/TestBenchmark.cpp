@@ -0,0 +1,662 @@
+/*
+* Tests for Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "Test/Test.h"
+
+#include "Cpl/Benchmark.h"
+#include "Cpl/Param.h"
+#include "Cpl/XmlPath.h"
+
+CPL_PARAM_ENUM1(Test, BenchColor,
+    BenchColorRed,
+    BenchColorOrange,
+    BenchColorYellow,
+    BenchColorGreen,
+    BenchColorCyan,
+    BenchColorBlue,
+    BenchColorViolet,
+    BenchColorBlack,
+    BenchColorWhite);
+
+namespace Test
+{
+#if defined(CPL_PERF_ENABLE)
+    static void StubBench(Cpl::BenchmarkState& state)
+    {
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(i);
+    }
+
+    bool BenchmarkSimpleTest()
+    {
+        Cpl::BenchmarkSamples samples = { 5.0, 1.0, 4.0, 2.0, 3.0 };
+        if (Cpl::BenchmarkMedian(samples) != 3.0 || Cpl::BenchmarkMad(samples) != 1.0)
+        {
+            CPL_LOG_SS(Error, "Wrong median or MAD!");
+            return false;
+        }
+
+        Cpl::BenchmarkResult result = Cpl::RunBenchmark("Stub", StubBench, Cpl::BenchmarkOptions(0.001, 0.001, 3));
+        if (result.samples.size() != 3 || result.iterations < 1 || result.median <= 0)
+        {
+            CPL_LOG_SS(Error, "Wrong benchmark result!");
+            return false;
+        }
+        CPL_LOG_SS(Verbose, std::endl << Cpl::BenchmarkTable(Cpl::BenchmarkResults(1, result)).GenerateText());
+        return true;
+    }
+
+    bool BenchmarkCompareTest()
+    {
+        Cpl::BenchmarkSamples fast = { 1.0, 2.0, 3.0, 4.0, 5.0 }, slow = { 6.0, 7.0, 8.0, 9.0, 10.0 }, mixed = { 1.5, 2.5, 3.5, 4.5, 5.5 };
+        double pSlow = Cpl::MannWhitneyPValue(fast, slow), pMixed = Cpl::MannWhitneyPValue(fast, mixed);
+        if (std::abs(pSlow - 2.0 / 252.0) > 0.000001 || pMixed < 0.5)
+        {
+            CPL_LOG_SS(Error, "Wrong Mann-Whitney p-values: " << pSlow << " " << pMixed << " !");
+            return false;
+        }
+
+        Cpl::BenchmarkResults baseline(1, Cpl::BenchmarkResult("Stub")), loaded, current;
+        baseline[0].iterations = 10;
+        baseline[0].samples = fast;
+        if (!Cpl::SaveBenchmarkBaseline("benchmark_baseline.xml", baseline) || !Cpl::LoadBenchmarkBaseline("benchmark_baseline.xml", loaded))
+            return false;
+        if (loaded.size() != 1 || loaded[0].samples != fast || loaded[0].median != 3.0)
+        {
+            CPL_LOG_SS(Error, "Wrong loaded benchmark baseline!");
+            return false;
+        }
+
+        current = loaded;
+        current[0].samples = slow;
+        current[0].median = Cpl::BenchmarkMedian(slow);
+        Cpl::BenchmarkComparisons comparisons = Cpl::CompareBenchmarks(loaded, current, 5.0, 0.05);
+        if (comparisons.size() != 1 || !comparisons[0].regression)
+        {
+            CPL_LOG_SS(Error, "Benchmark regression is not detected!");
+            return false;
+        }
+        CPL_LOG_SS(Verbose, std::endl << Cpl::BenchmarkCompareTable(comparisons).GenerateText());
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    void ToStrIntBench(Cpl::BenchmarkState& state)
+    {
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(Cpl::ToStr(int(i)));
+    }
+
+    void ToStrDoubleBench(Cpl::BenchmarkState& state)
+    {
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(Cpl::ToStr(double(i) * 0.125));
+    }
+
+    void ToValIntBench(Cpl::BenchmarkState& state)
+    {
+        const String value = "123456";
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(Cpl::ToVal<int>(value));
+    }
+
+    void ToValDoubleBench(Cpl::BenchmarkState& state)
+    {
+        const String value = "1234.5625";
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(Cpl::ToVal<double>(value));
+    }
+
+    void ToValEnumBench(Cpl::BenchmarkState& state)
+    {
+        const String value = "yellow";
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(Cpl::ToVal<BenchColor>(value));
+    }
+
+    void ToStrEnumBench(Cpl::BenchmarkState& state)
+    {
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(Cpl::ToStr(BenchColor(i % BenchColorSize)));
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    struct BenchItemParam
+    {
+        CPL_PARAM_VALUE(Int, id, 0);
+        CPL_PARAM_VALUE(String, name, "item");
+        CPL_PARAM_VALUE(double, weight, 0.5);
+        CPL_PARAM_VALUE(Strings, tags, Strings({ "a", "b" }));
+    };
+
+    struct BenchParam
+    {
+        CPL_PARAM_VALUE(String, name, "benchmark");
+        CPL_PARAM_VALUE(Int, version, 1);
+        CPL_PARAM_VECTOR(BenchItemParam, items);
+    };
+
+    CPL_PARAM_HOLDER(BenchParamHolder, BenchParam, bench);
+
+    struct BenchLazyParam
+    {
+        CPL_PARAM_VALUE(String, name, "benchmark");
+        CPL_PARAM_VALUE(Int, version, 1);
+        CPL_PARAM_VECTOR_LAZY(BenchItemParam, items);
+    };
+
+    CPL_PARAM_HOLDER(BenchLazyParamHolder, BenchLazyParam, bench);
+
+    static void BenchParamInit(BenchParamHolder& holder, size_t size)
+    {
+        holder().items().resize(size);
+        for (size_t i = 0; i < holder().items().size(); ++i)
+        {
+            holder().items()[i].id() = Int(i);
+            holder().items()[i].name() = "item_" + Cpl::ToStr(i);
+            holder().items()[i].weight() = double(i) / 64.0;
+        }
+    }
+
+    static const BenchParamHolder& BenchParamSample()
+    {
+        static BenchParamHolder holder;
+        if (holder().items().empty())
+            BenchParamInit(holder, 64);
+        return holder;
+    }
+
+    static const String& BenchParamText(Cpl::ParamFormat format)
+    {
+        static String texts[3];
+        String& text = texts[format];
+        if (text.empty())
+        {
+            std::stringstream ss;
+            BenchParamSample().Save(ss, true, format);
+            text = ss.str();
+        }
+        return text;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    template<int Flags> static void XmlParseBench(Cpl::BenchmarkState& state)
+    {
+        const String& text = BenchParamText(Cpl::ParamFormatXml);
+        const size_t batch = 64, size = text.size() + 1;
+        std::vector<char> buffers(batch * size);
+        Cpl::Xml::XmlDocument<char> doc;
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            if (i % batch == 0)
+            {
+                state.Pause();
+                for (size_t b = 0; b < batch; ++b)
+                    memcpy(buffers.data() + b * size, text.c_str(), size);
+                doc.Clear();
+                state.Resume();
+            }
+            doc.Parse<Flags>(buffers.data() + i % batch * size, text.size());
+            Cpl::DoNotOptimize(doc.FirstNode());
+        }
+    }
+
+    void XmlParseBench(Cpl::BenchmarkState& state)
+    {
+        XmlParseBench<Cpl::Xml::ParseDefault>(state);
+    }
+
+    void XmlParseValuesOnlyBench(Cpl::BenchmarkState& state)
+    {
+        XmlParseBench<Cpl::Xml::ParseValuesOnly>(state);
+    }
+
+    void XmlParseInternNamesBench(Cpl::BenchmarkState& state)
+    {
+        XmlParseBench<Cpl::Xml::ParseInternNames>(state);
+    }
+
+    void XmlPrintBench(Cpl::BenchmarkState& state)
+    {
+        String text = BenchParamText(Cpl::ParamFormatXml);
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.Parse<0>((char*)text.c_str(), text.size());
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            String output;
+            Cpl::Xml::Print(std::back_inserter(output), doc);
+            Cpl::DoNotOptimize(output);
+        }
+    }
+
+    static const String& BenchLargeXmlText()
+    {
+        static String text;
+        if (text.empty())
+        {
+            BenchParamHolder holder;
+            BenchParamInit(holder, 16384);
+            std::stringstream ss;
+            holder.Save(ss, true, Cpl::ParamFormatXml);
+            text = ss.str();
+        }
+        return text;
+    }
+
+    static void XmlParseLargeBench(Cpl::BenchmarkState& state, size_t threads)
+    {
+        const String& text = BenchLargeXmlText();
+        std::vector<char> buffer(text.size() + 1);
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            state.Pause();
+            memcpy(buffer.data(), text.c_str(), buffer.size());
+            Cpl::Xml::XmlDocument<char> doc;
+            state.Resume();
+            doc.ParseParallel<0>(buffer.data(), text.size(), threads);
+            Cpl::DoNotOptimize(doc.FirstNode());
+        }
+    }
+
+    void XmlParseLargeBench(Cpl::BenchmarkState& state)
+    {
+        XmlParseLargeBench(state, 1);
+    }
+
+    void XmlParseParallelBench(Cpl::BenchmarkState& state)
+    {
+        XmlParseLargeBench(state, 0);
+    }
+
+    template<int Flags> static void XmlPathBench(Cpl::BenchmarkState& state)
+    {
+        state.Pause();
+        String text = BenchLargeXmlText();
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.Parse<Flags>((char*)text.c_str(), text.size());
+        Cpl::Xml::XmlPath<char> path("/bench/items/item[16000]/name");
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(path.First(&doc));
+    }
+
+    void XmlPathBench(Cpl::BenchmarkState& state)
+    {
+        XmlPathBench<Cpl::Xml::ParseDefault>(state);
+    }
+
+    void XmlPathInternedBench(Cpl::BenchmarkState& state)
+    {
+        XmlPathBench<Cpl::Xml::ParseInternNames>(state);
+    }
+
+    void XmlPathManualBench(Cpl::BenchmarkState& state)
+    {
+        state.Pause();
+        String text = BenchLargeXmlText();
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.Parse<0>((char*)text.c_str(), text.size());
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            Cpl::Xml::XmlNode<char>* item = doc.FirstNode("bench")->FirstNode("items")->FirstNode("item");
+            for (size_t j = 1; j < 16000 && item; ++j)
+                item = item->NextSibling("item");
+            Cpl::DoNotOptimize(item ? item->FirstNode("name") : NULL);
+        }
+    }
+
+    void XmlPrintIteratorBench(Cpl::BenchmarkState& state)
+    {
+        state.Pause();
+        String text = BenchLargeXmlText();
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.Parse<0>((char*)text.c_str(), text.size());
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            std::stringstream ss;
+            Cpl::Xml::Print(std::ostream_iterator<char>(ss), doc);
+            Cpl::DoNotOptimize(ss);
+        }
+    }
+
+    void XmlPrintStreamBench(Cpl::BenchmarkState& state)
+    {
+        state.Pause();
+        String text = BenchLargeXmlText();
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.Parse<0>((char*)text.c_str(), text.size());
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            std::stringstream ss;
+            ss << doc;
+            Cpl::DoNotOptimize(ss);
+        }
+    }
+
+    void XmlPrintStringBench(Cpl::BenchmarkState& state)
+    {
+        state.Pause();
+        String text = BenchLargeXmlText();
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.Parse<0>((char*)text.c_str(), text.size());
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            String output;
+            Cpl::Xml::PrintToString(output, doc);
+            Cpl::DoNotOptimize(output);
+        }
+    }
+
+    void YamlParseBench(Cpl::BenchmarkState& state)
+    {
+        const String& text = BenchParamText(Cpl::ParamFormatYaml);
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            Cpl::Yaml::Node root;
+            Cpl::Yaml::Parse(root, text);
+            Cpl::DoNotOptimize(root);
+        }
+    }
+
+    void YamlSerializeBench(Cpl::BenchmarkState& state)
+    {
+        Cpl::Yaml::Node root;
+        Cpl::Yaml::Parse(root, BenchParamText(Cpl::ParamFormatYaml));
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            String output;
+            Cpl::Yaml::Serialize(root, output);
+            Cpl::DoNotOptimize(output);
+        }
+    }
+
+    void YamlSerializeFileBench(Cpl::BenchmarkState& state)
+    {
+        Cpl::Yaml::Node root;
+        Cpl::Yaml::Parse(root, BenchParamText(Cpl::ParamFormatYaml));
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            Cpl::DoNotOptimize(Cpl::Yaml::Serialize(root, "bench_serialize.yml"));
+    }
+
+    void YamlNodeAccessBench(Cpl::BenchmarkState& state)
+    {
+        state.Pause();
+        const size_t size = 1000;
+        Cpl::Yaml::Node root;
+        Strings keys(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            keys[i] = "key" + Cpl::ToStr(i);
+            root["map"][keys[i]] = Cpl::ToStr(i);
+            root["seq"].PushBack() = Cpl::ToStr(i);
+        }
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            size_t sum = 0;
+            for (size_t j = 0; j < size; ++j)
+                sum += root["map"][keys[j]].As<std::string>().size() + root["seq"][j].As<std::string>().size();
+            Cpl::DoNotOptimize(sum);
+        }
+    }
+
+    void YamlDocumentReaderBench(Cpl::BenchmarkState& state)
+    {
+        state.Pause();
+        std::stringstream records;
+        for (size_t i = 0; i < 1000; ++i)
+            records << "---\nid: " << i << "\nname: record" << i << "\nvalues: [1, 2, 3]\n";
+        const String text = records.str();
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            std::stringstream stream(text);
+            Cpl::Yaml::DocumentReader reader(stream);
+            Cpl::Yaml::Node root;
+            size_t sum = 0;
+            while (reader.Next(root))
+                sum += root["id"].As<size_t>();
+            Cpl::DoNotOptimize(sum);
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    void JsonParseBench(Cpl::BenchmarkState& state)
+    {
+        const String& text = BenchParamText(Cpl::ParamFormatJson);
+        const size_t batch = 64, size = text.size();
+        std::vector<char> buffers(batch * size);
+        Cpl::Json::Document doc;
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            if (i % batch == 0)
+            {
+                state.Pause();
+                for (size_t b = 0; b < batch; ++b)
+                    memcpy(buffers.data() + b * size, text.data(), size);
+                state.Resume();
+            }
+            doc.Parse(buffers.data() + i % batch * size, size);
+            Cpl::DoNotOptimize(doc.First());
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    static void ParamLoadBench(Cpl::BenchmarkState& state, Cpl::ParamFormat format)
+    {
+        const String& text = BenchParamText(format);
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            BenchParamHolder holder;
+            holder.Load(text.c_str(), text.size(), format);
+            Cpl::DoNotOptimize(holder);
+        }
+    }
+
+    static void ParamSaveBench(Cpl::BenchmarkState& state, Cpl::ParamFormat format)
+    {
+        const BenchParamHolder& holder = BenchParamSample();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            std::stringstream ss;
+            holder.Save(ss, true, format);
+            Cpl::DoNotOptimize(ss);
+        }
+    }
+
+    void ParamLoadXmlBench(Cpl::BenchmarkState& state)
+    {
+        ParamLoadBench(state, Cpl::ParamFormatXml);
+    }
+
+    void ParamLoadYamlBench(Cpl::BenchmarkState& state)
+    {
+        ParamLoadBench(state, Cpl::ParamFormatYaml);
+    }
+
+    void ParamSaveXmlBench(Cpl::BenchmarkState& state)
+    {
+        ParamSaveBench(state, Cpl::ParamFormatXml);
+    }
+
+    void ParamSaveYamlBench(Cpl::BenchmarkState& state)
+    {
+        ParamSaveBench(state, Cpl::ParamFormatYaml);
+    }
+
+    void ParamLoadJsonBench(Cpl::BenchmarkState& state)
+    {
+        ParamLoadBench(state, Cpl::ParamFormatJson);
+    }
+
+    void ParamSaveJsonBench(Cpl::BenchmarkState& state)
+    {
+        ParamSaveBench(state, Cpl::ParamFormatJson);
+    }
+
+    template<class Holder> static void ParamLoadLargeBench(Cpl::BenchmarkState& state, size_t threads, bool lazy = false)
+    {
+        state.Pause();
+        static String text;
+        if (text.empty())
+        {
+            BenchParamHolder sample;
+            BenchParamInit(sample, 16384);
+            std::stringstream ss;
+            sample.Save(ss, true, Cpl::ParamFormatXml);
+            text = ss.str();
+        }
+        Cpl::ParamLoadThreads::Set(threads);
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            Holder holder;
+            if (lazy)
+                holder.LoadLazy(text.c_str(), text.size(), Cpl::ParamFormatXml);
+            else
+                holder.Load(text.c_str(), text.size(), Cpl::ParamFormatXml);
+            Cpl::DoNotOptimize(holder().version());
+        }
+        state.Pause();
+        Cpl::ParamLoadThreads::Set(1);
+        state.Resume();
+    }
+
+    void ParamLoadLargeBench(Cpl::BenchmarkState& state)
+    {
+        ParamLoadLargeBench<BenchParamHolder>(state, 1);
+    }
+
+    void ParamLoadLargeParallelBench(Cpl::BenchmarkState& state)
+    {
+        ParamLoadLargeBench<BenchParamHolder>(state, 0);
+    }
+
+    void ParamLoadLargeLazyBench(Cpl::BenchmarkState& state)
+    {
+        ParamLoadLargeBench<BenchLazyParamHolder>(state, 1, true);
+    }
+
+    struct BenchArrayParam
+    {
+        CPL_PARAM_VALUE(std::vector<float>, value, std::vector<float>());
+        CPL_PARAM_ARRAY(float, text, Cpl::ParamArrayText);
+        CPL_PARAM_ARRAY(float, base64, Cpl::ParamArrayBase64);
+    };
+
+    CPL_PARAM_HOLDER(BenchArrayParamHolder, BenchArrayParam, bench);
+
+    static const String& BenchArrayText(int member)
+    {
+        static String texts[3];
+        String& text = texts[member];
+        if (text.empty())
+        {
+            BenchArrayParamHolder holder;
+            std::vector<float>& values = member == 0 ? holder().value() : (member == 1 ? holder().text() : holder().base64());
+            values.resize(65536);
+            for (size_t i = 0; i < values.size(); ++i)
+                values[i] = float(i) / 3.0f - 1000.0f;
+            std::stringstream ss;
+            holder.Save(ss, false, Cpl::ParamFormatXml);
+            text = ss.str();
+        }
+        return text;
+    }
+
+    static void ParamArrayLoadBench(Cpl::BenchmarkState& state, int member)
+    {
+        const String& text = BenchArrayText(member);
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            BenchArrayParamHolder holder;
+            holder.Load(text.c_str(), text.size(), Cpl::ParamFormatXml);
+            Cpl::DoNotOptimize(holder);
+        }
+    }
+
+    void ParamArrayLoadValueBench(Cpl::BenchmarkState& state)
+    {
+        ParamArrayLoadBench(state, 0);
+    }
+
+    void ParamArrayLoadTextBench(Cpl::BenchmarkState& state)
+    {
+        ParamArrayLoadBench(state, 1);
+    }
+
+    void ParamArrayLoadBase64Bench(Cpl::BenchmarkState& state)
+    {
+        ParamArrayLoadBench(state, 2);
+    }
+
+    void ParamCopyBench(Cpl::BenchmarkState& state)
+    {
+        state.Pause();
+        BenchParamHolder sample;
+        BenchParamInit(sample, 1024);
+        state.Resume();
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+        {
+            BenchParamHolder holder(sample);
+            Cpl::DoNotOptimize(holder);
+        }
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    static void SinkLogWrite(const char* msg, void*)
+    {
+        Cpl::DoNotOptimize(msg);
+    }
+
+    void LogWriteBench(Cpl::BenchmarkState& state)
+    {
+        Cpl::Log log;
+        log.AddWriter(Log::Info, SinkLogWrite, NULL);
+        const String message = "Benchmark message for Log::Write.";
+        for (size_t i = 0, n = state.Iterations(); i < n; ++i)
+            log.Write(Log::Info, message);
+    }
+#else
+    bool BenchmarkSimpleTest()
+    {
+        return true;
+    }
+
+    bool BenchmarkCompareTest()
+    {
+        return true;
+    }
+#endif
+}
@@ -0,0 +1,202 @@
+/*
+* Tests for Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include "Test/Test.h"
+
+#include "Cpl/Json.h"
+#include "Cpl/Param.h"
+
+namespace Test
+{
+    bool JsonParseTest()
+    {
+        String text =
+            "{\n"
+            "  \"name\": \"a \\\"quoted\\\" \\\\ \\/ \\u00e9\\u20ac\\ud83d\\ude00\",\n"
+            "  \"numbers\": [0, -1.5, 2e3, 12345678901234],\n"
+            "  \"flags\": { \"on\": true, \"off\": false, \"none\": null },\n"
+            "  \"empty\": {}\n"
+            "}";
+        Cpl::Json::Document doc;
+        try
+        {
+            doc.Parse((char*)text.data(), text.size());
+        }
+        catch (const std::exception& e)
+        {
+            CPL_LOG_SS(Error, "Can't parse JSON: " << e.what());
+            return false;
+        }
+        Cpl::Json::Value* name = doc.Find("name"), * numbers = doc.Find("numbers"), * flags = doc.Find("flags");
+        if (doc.GetType() != Cpl::Json::Value::ObjectType || doc.Count() != 4 || name == NULL || numbers == NULL || flags == NULL)
+        {
+            CPL_LOG_SS(Error, "Wrong JSON structure!");
+            return false;
+        }
+        if (name->AsString() != "a \"quoted\" \\ / \xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80")
+        {
+            CPL_LOG_SS(Error, "Wrong JSON string unescaping: " << name->AsString());
+            return false;
+        }
+        if (numbers->Count() != 4 || numbers->First()->Next()->AsString() != "-1.5" || numbers->First()->Next()->Next()->AsString() != "2e3")
+        {
+            CPL_LOG_SS(Error, "Wrong JSON numbers!");
+            return false;
+        }
+        if (flags->Find("on")->GetType() != Cpl::Json::Value::TrueType || flags->Find("off")->AsString() != "false" ||
+            flags->Find("none")->GetType() != Cpl::Json::Value::NullType || doc.Find("empty")->Count() != 0)
+        {
+            CPL_LOG_SS(Error, "Wrong JSON literals!");
+            return false;
+        }
+
+        std::stringstream ss;
+        {
+            Cpl::Json::Writer writer(ss, 0);
+            writer.BeginObject();
+            writer.Key("text");
+            writer.Text(name->AsString() + "\n\t\x01");
+            writer.Key("list");
+            writer.BeginArray();
+            writer.Number("1", 1);
+            writer.Bool(false);
+            writer.Null();
+            writer.BeginObject();
+            writer.EndObject();
+            writer.EndArray();
+            writer.EndObject();
+        }
+        if (ss.str() != "{\"text\":\"a \\\"quoted\\\" \\\\ / \xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\\n\\t\\u0001\",\"list\":[1,false,null,{}]}")
+        {
+            CPL_LOG_SS(Error, "Wrong JSON writer output: " << ss.str());
+            return false;
+        }
+
+        const char* wrongs[] = { "{\"a\":1,}", "[1 2]", "{\"a\" 1}", "\"open", "[01]", "[1.]", "tru", "{} {}", "[\"\\x\"]",
+            "[\"\\udc00\"]", "[\"\\ud800\"]", "[\"\\ud800\\u0041\"]" };
+        for (size_t i = 0; i < sizeof(wrongs) / sizeof(wrongs[0]); ++i)
+        {
+            String wrong = wrongs[i];
+            try
+            {
+                doc.Parse((char*)wrong.data(), wrong.size());
+                CPL_LOG_SS(Error, "Wrong JSON '" << wrongs[i] << "' is parsed!");
+                return false;
+            }
+            catch (const Cpl::Json::ParseError&)
+            {
+            }
+        }
+
+        const size_t depth = Cpl::Json::MAX_NESTING_DEPTH;
+        String deep = String(depth, '[') + String(depth, ']');
+        try
+        {
+            doc.Parse((char*)deep.data(), deep.size());
+        }
+        catch (const Cpl::Json::ParseError& e)
+        {
+            CPL_LOG_SS(Error, "JSON nested " << depth << " levels deep is not parsed: " << e.what());
+            return false;
+        }
+        String deeper = String(depth, '[') + "{\"a\":1}" + String(depth, ']');
+        try
+        {
+            doc.Parse((char*)deeper.data(), deeper.size());
+            CPL_LOG_SS(Error, "JSON nested " << depth + 1 << " levels deep is parsed!");
+            return false;
+        }
+        catch (const Cpl::Json::ParseError&)
+        {
+        }
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    bool JsonParamTest()
+    {
+        struct SubParam
+        {
+            CPL_PARAM_VALUE(Int, id, 1);
+            CPL_PARAM_VALUE(String, desc, "no");
+        };
+
+        struct TestParam
+        {
+            CPL_PARAM_VALUE(String, name, "Name");
+            CPL_PARAM_VALUE(Int, value, 0);
+            CPL_PARAM_VALUE(double, ratio, 0.5);
+            CPL_PARAM_VALUE(bool, flag, false);
+            CPL_PARAM_VALUE(Strings, letters, Strings({ "A", "B", "C" }));
+            CPL_PARAM_STRUCT(SubParam, sub);
+            CPL_PARAM_STRUCT(SubParam, orig);
+            CPL_PARAM_LIMITED(Int, lim, 3, 0, 5);
+            CPL_PARAM_VECTOR(SubParam, subs);
+            CPL_PARAM_MAP(String, SubParam, dict);
+        };
+
+        CPL_PARAM_HOLDER(TestParamHolder, TestParam, test);
+
+        TestParamHolder test;
+
+        test().name() = "Changed \"name\"";
+        test().ratio() = 0.125;
+        test().flag() = true;
+        test().sub().desc() = "description";
+        test().lim() = 4;
+        test().subs().resize(3);
+        test().subs()[0].id() = 7;
+        test().subs()[1].desc() = "seven";
+        test().dict()["A"].desc() = "A";
+        test().dict()["B"];
+
+        test.Save("json_short.json", false);
+        test.Save("json_full.json", true);
+
+        const char* files[] = { "json_short.json", "json_full.json" };
+        for (size_t i = 0; i < 2; ++i)
+        {
+            TestParamHolder loaded;
+            if (!loaded.Load(files[i]))
+                return false;
+            if (!loaded.Equal(test))
+            {
+                CPL_LOG_SS(Error, "loaded " << files[i] << " != original");
+                loaded.Save("json_full_loaded.json", true);
+                return false;
+            }
+        }
+
+        const String text = "{ \"test\": { \"lim\": 9, \"unknown\": [1, 2], \"value\": -3, \"dict\": { \"C\": { \"id\": 5 } } } }";
+        TestParamHolder loaded;
+        if (!loaded.Load(text.c_str(), text.size(), Cpl::ParamFormatJson) || loaded().lim() != 3 || loaded().value() != -3 || loaded().dict()["C"].id() != 5)
+        {
+            CPL_LOG_SS(Error, "Wrong loading of JSON text!");
+            return false;
+        }
+        return true;
+    }
+}
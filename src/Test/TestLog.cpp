@@ -71,25 +71,42 @@ namespace Test
 
     //-------------------------------------------------------------------------------------------------
 
+    static void CollectWriter(const char* msg, void* userData)
+    {
+        ((Strings*)userData)->push_back(msg);
+    }
+
     bool LogDateTimeTest()
     {
-        Cpl::Log::Flags flags = Cpl::Log::Global().GetFlags();
+        Strings messages;
+        Cpl::Log log;
+        log.AddWriter(Cpl::Log::Info, CollectWriter, &messages);
+
+        log.SetFlags(Cpl::Log::Flags(Cpl::Log::DefaultFlags | Cpl::Log::WriteDate));
+
+        log.Write(Cpl::Log::Info, "Write date in message");
 
-        Cpl::Log::Global().SetFlags(Cpl::Log::Flags(flags | Cpl::Log::WriteDate));
+        log.SetFlags(Cpl::Log::Flags(Cpl::Log::DefaultFlags | Cpl::Log::WriteTime));
 
-        CPL_LOG(Info, "Write date in message");
+        log.Write(Cpl::Log::Info, "Write time in message");
 
-        Cpl::Log::Global().SetFlags(Cpl::Log::Flags(flags | Cpl::Log::WriteTime));
+        log.SetFlags(Cpl::Log::Flags(Cpl::Log::DefaultFlags | Cpl::Log::WriteDate | Cpl::Log::WriteTime));
 
-        CPL_LOG(Info, "Write time in message");
+        log.Write(Cpl::Log::Info, "Write date and time in message");
 
-        Cpl::Log::Global().SetFlags(Cpl::Log::Flags(flags | Cpl::Log::WriteDate | Cpl::Log::WriteTime));
+        log.SetFlags(Cpl::Log::DefaultFlags);
 
-        CPL_LOG(Info, "Write date and time in message");
+        log.Write(Cpl::Log::Info, "Write no date or time in message");
 
-        Cpl::Log::Global().SetFlags(flags);
+        for (size_t i = 0; i < messages.size(); ++i)
+            CPL_LOG_SS(Info, messages[i].substr(0, messages[i].size() - 1));
 
-        CPL_LOG(Info, "Write no date or time in message");
+        if (messages.size() != 4 || !isdigit(messages[0][0]) || !isdigit(messages[1][0]) || messages[3][0] != '[' ||
+            messages[2].find("Write") <= messages[0].find("Write") || messages[2].find("Write") <= messages[1].find("Write"))
+        {
+            CPL_LOG_SS(Error, "Wrong date and time in log messages!");
+            return false;
+        }
 
         return true;
     }
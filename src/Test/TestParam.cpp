@@ -214,6 +214,13 @@ namespace Test
         test.Save("enum_short.xml", false);
         test.Save("enum_full.xml", true);
 
+        if (Cpl::ToStr(A::B::Enum3) != "3" || Cpl::ToStr((A::B::Enum)7) != "" ||
+            Cpl::ToVal<A::Enum>("4") != A::Enum4 || Cpl::ToVal<Enum>("5") != EnumUnknown)
+        {
+            CPL_LOG_SS(Error, "Wrong conversion of enum to/from string!");
+            return false;
+        }
+
         if (!loaded.Load("enum_full.xml"))
             return false;
 
@@ -317,14 +324,35 @@ namespace Test
 
         copy.Clone(test);
 
-        test.Save("map_short.xml", false);
-        copy.Save("map_copy_full.xml", true);
+        test.Save("map_bug_short.xml", false);
+        copy.Save("map_bug_copy_full.xml", true);
 
-        if (!loaded.Load("map_copy_full.xml"))
+        if (!loaded.Load("map_bug_copy_full.xml"))
             return false;
 
         return loaded.Equal(test);
     }
+
+    bool ParamEnumCaseTest()
+    {
+        const char* names[] = { "fp32", "INT8", "Fp16", "fP16" };
+        const A::NetworkMode modes[] = { A::NetworkModeFp32, A::NetworkModeInt8, A::NetworkModeFp16, A::NetworkModeFp16 };
+        for (size_t i = 0; i < 4; ++i)
+        {
+            if (Cpl::ToVal<A::NetworkMode>(names[i]) != modes[i])
+            {
+                CPL_LOG_SS(Error, "Can't convert '" << names[i] << "' to A::NetworkMode!");
+                return false;
+            }
+        }
+        if (Cpl::ToVal<A::NetworkMode>("Fp") != A::NetworkModeUnknown || Cpl::ToVal<A::NetworkMode>("Fp160") != A::NetworkModeUnknown ||
+            Cpl::ToVal<A::DeviceType>("") != A::DeviceTypeUnknown || Cpl::GetEnumTable<A::DeviceType>().Name(A::DeviceTypeCpu) != "Cpu")
+        {
+            CPL_LOG_SS(Error, "Wrong conversion of unknown enum value!");
+            return false;
+        }
+        return true;
+    }
 }
 
 //---------------------------------------------------------------------------------------------
@@ -355,6 +383,34 @@ namespace Test
 
         return loaded.Equal(test);
     }
+
+    bool ParamEntitiesTest()
+    {
+        struct TestParam
+        {
+            CPL_PARAM_VALUE(String, name, "Name");
+            CPL_PARAM_VALUE(String, text, "");
+        };
+
+        CPL_PARAM_HOLDER(TestParamHolder, TestParam, test);
+
+        TestParamHolder test, loaded;
+
+        test().name() = "&amp; is <not> expanded twice";
+        test().text() = "Tom & \"Jerry\" <'cat' & 'mouse'>";
+
+        test.Save("entities_full.xml", true);
+
+        if (!loaded.Load("entities_full.xml"))
+            return false;
+
+        if (!loaded.Equal(test))
+        {
+            CPL_LOG_SS(Error, "Loaded text '" << loaded().text() << "' != '" << test().text() << "' !");
+            return false;
+        }
+        return true;
+    }
 }
 
 //---------------------------------------------------------------------------------------------
@@ -405,6 +461,486 @@ namespace Test
 
         return true;
     }
+    //---------------------------------------------------------------------------------------------
+
+    bool ParamSchemaTest()
+    {
+        struct ItemParam
+        {
+            CPL_PARAM_VALUE(Int, id, 0);
+            CPL_PARAM_VALUE(double, weight, 1.0);
+        };
+
+        struct TestParam
+        {
+            CPL_PARAM_VALUE(String, name, "Name");
+            CPL_PARAM_VALUE(Int, count, 0);
+            CPL_PARAM_VECTOR(ItemParam, items);
+        };
+
+        CPL_PARAM_HOLDER(TestParamHolder, TestParam, test);
+
+        const String xml =
+            "<?xml version=\"1.0\"?>\n"
+            "<test>\n"
+            "  <items>\n"
+            "    <item><weight>2.5</weight><unknown>x</unknown><id>7</id><id>8</id></item>\n"
+            "    <item><id>9</id></item>\n"
+            "  </items>\n"
+            "  <name>reordered</name>\n"
+            "  <count>3</count>\n"
+            "</test>\n";
+        TestParamHolder fromXml;
+        if (!fromXml.Load(xml.c_str(), xml.size(), Cpl::ParamFormatXml) || fromXml().name() != "reordered" || fromXml().count() != 3 ||
+            fromXml().items().size() != 2 || fromXml().items()[0].id() != 7 || fromXml().items()[0].weight() != 2.5 ||
+            fromXml().items()[1].id() != 9 || fromXml().items()[1].weight() != 1.0)
+        {
+            CPL_LOG_SS(Error, "Wrong loading of reordered XML!");
+            return false;
+        }
+
+        const String yaml =
+            "test:\n"
+            "  count: 4\n"
+            "  items:\n"
+            "    - weight: 1.5\n"
+            "      unknown: x\n"
+            "      id: 5\n"
+            "  name: yaml\n";
+        TestParamHolder fromYaml;
+        if (!fromYaml.Load(yaml.c_str(), yaml.size(), Cpl::ParamFormatYaml) || fromYaml().name() != "yaml" || fromYaml().count() != 4 ||
+            fromYaml().items().size() != 1 || fromYaml().items()[0].id() != 5 || fromYaml().items()[0].weight() != 1.5)
+        {
+            CPL_LOG_SS(Error, "Wrong loading of reordered YAML!");
+            return false;
+        }
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    bool ParamPatchTest()
+    {
+        struct ItemParam
+        {
+            CPL_PARAM_VALUE(Int, id, 0);
+            CPL_PARAM_VALUE(String, name, "Name");
+        };
+
+        struct TestParam
+        {
+            CPL_PARAM_VALUE(String, name, "Name");
+            CPL_PARAM_LIMITED(Int, value, 0, -5, 6);
+            CPL_PARAM_STRUCT(ItemParam, child);
+            CPL_PARAM_VECTOR(ItemParam, items);
+            CPL_PARAM_MAP(String, ItemParam, map);
+        };
+
+        CPL_PARAM_HOLDER(TestParamHolder, TestParam, test);
+
+        TestParamHolder source, target;
+        source().items().resize(3);
+        source().map()["a"].id() = 1;
+        source().map()["b/c"].id() = 2;
+        source().map()["d"].id() = 3;
+        target.Clone(source);
+        if (!source.Diff(target).Empty())
+        {
+            CPL_LOG_SS(Error, "Diff of equal Params is not empty!");
+            return false;
+        }
+
+        target().value() = 4;
+        target().child().name() = "Child";
+        target().items()[1].id() = 11;
+        target().items().resize(5);
+        target().items()[4].name() = "Last";
+        target().map().erase("a");
+        target().map()["b/c"].name() = "BC";
+        target().map()["e"].id() = 5;
+        target().map()["f"];
+
+        Cpl::ParamPatch patch = source.Diff(target);
+        if (patch.Size() != 10)
+        {
+            CPL_LOG_SS(Error, "Diff has " << patch.Size() << " changes instead of 10!");
+            return false;
+        }
+        for (int format = Cpl::ParamFormatXml; format <= Cpl::ParamFormatJson; ++format)
+        {
+            std::stringstream ss;
+            Cpl::ParamPatch loaded;
+            if (!patch.Save(ss, (Cpl::ParamFormat)format) || !loaded.Load(ss.str().c_str(), ss.str().size(), (Cpl::ParamFormat)format))
+            {
+                CPL_LOG_SS(Error, "Can't save and load patch in " << Cpl::ToStr((Cpl::ParamFormat)format) << " format!");
+                return false;
+            }
+            TestParamHolder patched;
+            patched.Clone(source);
+            if (!patched.Apply(loaded) || !patched.Equal(target))
+            {
+                CPL_LOG_SS(Error, "Patched Param != target in " << Cpl::ToStr((Cpl::ParamFormat)format) << " format!");
+                return false;
+            }
+        }
+
+        const String texts[] = { "", " lead", "trail ", "\"q\"", "a: b # c", "50% \\", "two\nlines" };
+        for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i)
+        {
+            TestParamHolder textual;
+            textual.Clone(source);
+            textual().name() = texts[i];
+            textual().map()[texts[i]].name() = texts[i];
+            Cpl::ParamPatch textPatch = source.Diff(textual);
+            for (int format = Cpl::ParamFormatXml; format <= Cpl::ParamFormatJson; ++format)
+            {
+                std::stringstream ss;
+                Cpl::ParamPatch loaded;
+                TestParamHolder patched;
+                patched.Clone(source);
+                if (!textPatch.Save(ss, (Cpl::ParamFormat)format) || !loaded.Load(ss.str().c_str(), ss.str().size(), (Cpl::ParamFormat)format) ||
+                    !patched.Apply(loaded) || !patched.Equal(textual))
+                {
+                    CPL_LOG_SS(Error, "Patch with value '" << texts[i] << "' doesn't round-trip in " << Cpl::ToStr((Cpl::ParamFormat)format) << " format!");
+                    return false;
+                }
+            }
+        }
+
+        TestParamHolder reverted;
+        reverted.Clone(target);
+        if (!reverted.Apply(target.Diff(source)) || !reverted.Equal(source))
+        {
+            CPL_LOG_SS(Error, "Reverted Param != source!");
+            return false;
+        }
+
+        Cpl::ParamPatch wrong;
+        wrong.Add(Cpl::ParamPatch::OpSet, "/unknown", "1");
+        if (reverted.Apply(wrong))
+        {
+            CPL_LOG_SS(Error, "Patch with unknown path is applied!");
+            return false;
+        }
+
+        const Cpl::ParamPatch::Change malformed[] = { { Cpl::ParamPatch::OpSet, "/value", "abc" }, { Cpl::ParamPatch::OpSet, "/value", "3x" },
+            { Cpl::ParamPatch::OpSet, "/items/1/id", "" }, { Cpl::ParamPatch::OpResize, "/items", "-1" }, { Cpl::ParamPatch::OpResize, "/items", "many" },
+            { Cpl::ParamPatch::OpSet, "/items/one/id", "1" }, { Cpl::ParamPatch::OpSet, "/items//id", "1" } };
+        for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); ++i)
+        {
+            Cpl::ParamPatch bad;
+            bad.Add(malformed[i].op, malformed[i].path, malformed[i].value);
+            TestParamHolder unchanged;
+            unchanged.Clone(source);
+            if (unchanged.Apply(bad) || !unchanged.Equal(source))
+            {
+                CPL_LOG_SS(Error, "Malformed patch '" << malformed[i].path << "' = '" << malformed[i].value << "' is applied!");
+                return false;
+            }
+        }
+
+        Cpl::ParamPatch partial = source.Diff(target);
+        partial.Add(Cpl::ParamPatch::OpSet, "/value", "abc");
+        TestParamHolder unchanged;
+        unchanged.Clone(source);
+        if (unchanged.Apply(partial) || !unchanged.Equal(source))
+        {
+            CPL_LOG_SS(Error, "Patch with failed last change is partially applied!");
+            return false;
+        }
+
+        Cpl::ParamPatch moving;
+        moving.Add(Cpl::ParamPatch::OpSet, "/items/0/id", "7");
+        moving.Add(Cpl::ParamPatch::OpResize, "/items", "1000");
+        moving.Add(Cpl::ParamPatch::OpSet, "/items/999/name", "Far");
+        moving.Add(Cpl::ParamPatch::OpResize, "/items", "1");
+        moving.Add(Cpl::ParamPatch::OpSet, "/map/a/name", "A");
+        moving.Add(Cpl::ParamPatch::OpErase, "/map/a");
+        moving.Add(Cpl::ParamPatch::OpInsert, "/map/d");
+        moving.Add(Cpl::ParamPatch::OpInsert, "/map/z");
+        moving.Add(Cpl::ParamPatch::OpSet, "/child/id", "x");
+        unchanged.Clone(source);
+        if (unchanged.Apply(moving) || !unchanged.Equal(source))
+        {
+            CPL_LOG_SS(Error, "Patch which moves nodes before failure is partially applied!");
+            return false;
+        }
+
+        const String valueless[] = {
+            "<patch><change><op>set</op><path>/value</path></change></patch>",
+            "- op: resize\n  path: /items\n",
+            "[{\"op\": \"set\", \"path\": \"/value\"}]" };
+        for (int format = Cpl::ParamFormatXml; format <= Cpl::ParamFormatJson; ++format)
+        {
+            const String& text = valueless[format - Cpl::ParamFormatXml];
+            Cpl::ParamPatch loaded;
+            if (loaded.Load(text.c_str(), text.size(), (Cpl::ParamFormat)format))
+            {
+                CPL_LOG_SS(Error, "Patch change without value is loaded in " << Cpl::ToStr((Cpl::ParamFormat)format) << " format!");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    bool ParamArrayTest()
+    {
+        for (size_t size = 0; size < 8; ++size)
+        {
+            uint8_t src[8] = { 0xFF, 0x00, 0x7F, 0x80, 0x3E, 0x3F, 0xFB, 0x01 }, dst[8];
+            String text = Cpl::ToBase64(src, size);
+            if (Cpl::FromBase64(text.c_str(), text.size(), dst) != (ptrdiff_t)size || memcmp(src, dst, size) != 0)
+            {
+                CPL_LOG_SS(Error, "Base64 round trip of " << size << " bytes is failed: '" << text << "' !");
+                return false;
+            }
+        }
+
+        struct TestParam
+        {
+            CPL_PARAM_VALUE(String, name, "Name");
+            CPL_PARAM_ARRAY(float, weights, Cpl::ParamArrayText);
+            CPL_PARAM_ARRAY(double, values, Cpl::ParamArrayBase64);
+            CPL_PARAM_ARRAY(int16_t, codes, Cpl::ParamArrayText);
+            CPL_PARAM_ARRAY(uint8_t, bytes, Cpl::ParamArrayBase64);
+        };
+
+        CPL_PARAM_HOLDER(TestParamHolder, TestParam, test);
+
+        TestParamHolder test;
+        for (int i = 0; i < 1000; ++i)
+        {
+            test().weights().push_back(float(i) / 7.0f - 50.0f);
+            test().values().push_back(double(i) * 1.0e-3 + 1.0 / 3.0);
+            test().codes().push_back(int16_t(i * 37 - 32768));
+            test().bytes().push_back(uint8_t(i * 13));
+        }
+        test().weights().push_back(std::numeric_limits<float>::max());
+        test().values().push_back(-std::numeric_limits<double>::min());
+
+        for (int format = Cpl::ParamFormatXml; format <= Cpl::ParamFormatJson; ++format)
+        {
+            std::stringstream ss;
+            TestParamHolder loaded;
+            if (!test.Save(ss, false, (Cpl::ParamFormat)format) || !loaded.Load(ss.str().c_str(), ss.str().size(), (Cpl::ParamFormat)format) || !loaded.Equal(test))
+            {
+                CPL_LOG_SS(Error, "ParamArray save and load in " << Cpl::ToStr((Cpl::ParamFormat)format) << " format is failed!");
+                return false;
+            }
+        }
+
+        TestParamHolder loaded;
+        String text = "<test><weights>1.5, -2 3e2\n 4</weights><values>0.25 0.5</values><bytes>base64:AQID</bytes></test>";
+        if (!loaded.Load(text.c_str(), text.size(), Cpl::ParamFormatXml) || loaded().weights() != std::vector<float>({ 1.5f, -2.0f, 300.0f, 4.0f }) ||
+            loaded().values() != std::vector<double>({ 0.25, 0.5 }) || loaded().bytes() != std::vector<uint8_t>({ 1, 2, 3 }))
+        {
+            CPL_LOG_SS(Error, "ParamArray loading of mixed encodings is failed!");
+            return false;
+        }
+
+        const char* wrongs[] = { "<test><weights>1.5 x</weights></test>", "<test><codes>40000</codes></test>", "<test><values>base64:AQID</values></test>" };
+        for (size_t i = 0; i < 3; ++i)
+        {
+            TestParamHolder wrong;
+            wrong.Clone(test);
+            text = wrongs[i];
+            wrong.Load(text.c_str(), text.size(), Cpl::ParamFormatXml);
+            size_t sizes[3] = { wrong().weights().size(), wrong().codes().size(), wrong().values().size() };
+            if (sizes[i] != 0)
+            {
+                CPL_LOG_SS(Error, "Wrong ParamArray '" << text << "' is loaded!");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    namespace
+    {
+        struct LeafParam
+        {
+            CPL_PARAM_VALUE(Int, value, 0);
+        };
+
+        struct ItemParam
+        {
+            CPL_PARAM_VALUE(String, name, "");
+            CPL_PARAM_VECTOR(LeafParam, leaves);
+            CPL_PARAM_VALUE(Int, value, 0);
+        };
+
+        struct ParallelParam
+        {
+            CPL_PARAM_VECTOR(ItemParam, items);
+            CPL_PARAM_MAP(String, ItemParam, map);
+        };
+
+        CPL_PARAM_HOLDER(ParallelParamHolder, ParallelParam, parallel);
+
+        struct LazyItemParam
+        {
+            CPL_PARAM_VALUE(String, name, "");
+            CPL_PARAM_VECTOR_LAZY(LeafParam, leaves);
+            CPL_PARAM_VALUE(Int, value, 0);
+        };
+
+        struct LazyParam
+        {
+            CPL_PARAM_STRUCT_LAZY(LeafParam, leaf);
+            CPL_PARAM_VECTOR_LAZY(LazyItemParam, items);
+            CPL_PARAM_MAP(String, LazyItemParam, map);
+        };
+
+        CPL_PARAM_HOLDER(LazyParamHolder, LazyParam, parallel);
+
+        struct LoadThreadsGuard
+        {
+            size_t threads, minItems;
+
+            LoadThreadsGuard()
+                : threads(Cpl::ParamLoadThreads::Threads().load())
+                , minItems(Cpl::ParamLoadThreads::MinItems().load())
+            {
+            }
+
+            ~LoadThreadsGuard()
+            {
+                Cpl::ParamLoadThreads::Set(threads, minItems);
+            }
+        };
+
+        bool LoadParallel(const String& text, Cpl::ParamFormat format, size_t threads, ParallelParamHolder& param)
+        {
+            LoadThreadsGuard guard;
+            Cpl::ParamLoadThreads::Set(threads, 16);
+            return param.Load(text.c_str(), text.size(), format);
+        }
+    }
+
+    bool ParamParallelLoadTest()
+    {
+        const size_t size = 1000;
+        ParallelParamHolder source;
+        source().items().resize(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            ItemParam& item = source().items()[i];
+            item.name() = "item" + Cpl::ToStr(i);
+            item.value() = (int)i;
+            item.leaves().resize(i % 5);
+            for (size_t j = 0; j < item.leaves().size(); ++j)
+                item.leaves()[j].value() = int(i * 10 + j);
+            source().map()["key" + Cpl::ToStr(i)] = item;
+        }
+
+        for (int format = Cpl::ParamFormatXml; format <= Cpl::ParamFormatJson; ++format)
+        {
+            std::stringstream ss;
+            source.Save(ss, false, (Cpl::ParamFormat)format);
+            ParallelParamHolder serial, parallel;
+            if (!LoadParallel(ss.str(), (Cpl::ParamFormat)format, 1, serial) || !LoadParallel(ss.str(), (Cpl::ParamFormat)format, 4, parallel) ||
+                !serial.Equal(source) || !parallel.Equal(serial))
+            {
+                CPL_LOG_SS(Error, "Parallel loading in " << Cpl::ToStr((Cpl::ParamFormat)format) << " format differs from serial one!");
+                return false;
+            }
+        }
+
+        ParallelParamHolder broken;
+        broken.Clone(source);
+        broken().items()[size / 3].name() = "broken";
+        broken().map()["key" + Cpl::ToStr(size / 3)].name() = "broken";
+        std::stringstream ss;
+        broken.Save(ss, false, Cpl::ParamFormatXml);
+        String text = ss.str();
+        String name = "<name>broken</name>", leaves = "<leaves><wrong/></leaves>";
+        for (size_t pos = text.find(name); pos != String::npos; pos = text.find(name, pos + leaves.size() + name.size()))
+            text.insert(pos, leaves);
+        ParallelParamHolder reloaded, serial, parallel;
+        reloaded().items().resize(size * 7 / 10);
+        reloaded().items()[size * 7 / 10 - 1].value() = 7;
+        serial.Clone(reloaded);
+        parallel.Clone(reloaded);
+        bool serialResult = LoadParallel(text, Cpl::ParamFormatXml, 1, serial);
+        bool parallelResult = LoadParallel(text, Cpl::ParamFormatXml, 4, parallel);
+        if (serialResult != parallelResult || !parallel.Equal(serial))
+        {
+            CPL_LOG_SS(Error, "Parallel loading of broken items differs from serial one!");
+            return false;
+        }
+        if (serial().items()[size * 7 / 10 - 1].value() != 7 || serial().items()[size - 1].value() != 0 || serial().map().count("key999"))
+        {
+            CPL_LOG_SS(Error, "Serial loading of broken items has unexpected result!");
+            return false;
+        }
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    bool ParamLazyTest()
+    {
+        const size_t size = 100;
+        LazyParamHolder source;
+        source().leaf().value() = 7;
+        source().items().resize(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            LazyItemParam& item = source().items()[i];
+            item.name() = "item" + Cpl::ToStr(i);
+            item.value() = (int)i;
+            item.leaves().resize(i % 5);
+            for (size_t j = 0; j < item.leaves().size(); ++j)
+                item.leaves()[j].value() = int(i * 10 + j);
+            source().map()["key" + Cpl::ToStr(i)] = item;
+        }
+
+        for (int format = Cpl::ParamFormatXml; format <= Cpl::ParamFormatJson; ++format)
+        {
+            LazyParamHolder accessed, materialized;
+            {
+                std::stringstream ss;
+                source.Save(ss, false, (Cpl::ParamFormat)format);
+                String text = ss.str();
+                if (!accessed.LoadLazy(text.c_str(), text.size(), (Cpl::ParamFormat)format) ||
+                    !materialized.LoadLazy(text.c_str(), text.size(), (Cpl::ParamFormat)format))
+                {
+                    CPL_LOG_SS(Error, "Lazy loading in " << Cpl::ToStr((Cpl::ParamFormat)format) << " format is failed!");
+                    return false;
+                }
+            }
+            std::vector<std::thread> threads;
+            std::atomic<int> sum(0);
+            for (size_t t = 0; t < 4; ++t)
+                threads.push_back(std::thread([&accessed, &sum, t]() { sum += accessed().items()[t * 10 + 3].leaves()[2].value(); }));
+            for (size_t t = 0; t < threads.size(); ++t)
+                threads[t].join();
+            if (sum != 32 + 132 + 232 + 332 || !accessed.Equal(source) || !materialized.Materialize() || !materialized.Equal(source))
+            {
+                CPL_LOG_SS(Error, "Lazy loading in " << Cpl::ToStr((Cpl::ParamFormat)format) << " format differs from eager one!");
+                return false;
+            }
+        }
+
+        String text = "<parallel><items><item><name>a</name><leaves><wrong/></leaves></item></items></parallel>";
+        LazyParamHolder broken;
+        if (!broken.LoadLazy(text.c_str(), text.size(), Cpl::ParamFormatXml) || broken.Materialize())
+        {
+            CPL_LOG_SS(Error, "Lazy loading of broken nested vector is not reported by Materialize()!");
+            return false;
+        }
+        ParallelParamHolder plain;
+        if (!plain.LoadLazy(text.c_str(), text.size(), Cpl::ParamFormatXml) || !plain.Materialize() || plain().items().size() != 1)
+        {
+            CPL_LOG_SS(Error, "Plain nested vector is deferred by lazy loading!");
+            return false;
+        }
+        return true;
+    }
 }
 
 
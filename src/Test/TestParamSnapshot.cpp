@@ -0,0 +1,138 @@
+/*
+* Tests for Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "Test/Test.h"
+
+#include "Cpl/ParamSnapshot.h"
+
+#include <thread>
+
+namespace Test
+{
+    struct SnapshotParam
+    {
+        CPL_PARAM_VALUE(Int, first, 0);
+        CPL_PARAM_VALUE(Int, second, 0);
+        CPL_PARAM_VALUE(String, name, "Name");
+    };
+
+    CPL_PARAM_HOLDER(SnapshotParamHolder, SnapshotParam, snapshot);
+
+    typedef Cpl::ParamSnapshot<SnapshotParamHolder> Snapshot;
+
+    static void SnapshotChanged(const Snapshot::Pointer&, const Snapshot::Pointer&, const Strings& changed, void* userData)
+    {
+        *(Strings*)userData = changed;
+    }
+
+    struct SnapshotOnce
+    {
+        Snapshot* snapshot;
+        int id;
+        size_t calls;
+    };
+
+    static void SnapshotChangedOnce(const Snapshot::Pointer&, const Snapshot::Pointer&, const Strings&, void* userData)
+    {
+        SnapshotOnce* once = (SnapshotOnce*)userData;
+        once->calls++;
+        once->snapshot->RemoveCallback(once->id);
+    }
+
+    bool ParamSnapshotTest()
+    {
+        Snapshot snapshot;
+        Strings changed;
+        snapshot.AddCallback(SnapshotChanged, &changed);
+        SnapshotOnce once = { &snapshot, 0, 0 };
+        once.id = snapshot.AddCallback(SnapshotChangedOnce, &once);
+
+        const size_t updates = 200;
+        std::atomic<bool> stop(false), error(false);
+        std::vector<std::thread> readers;
+        for (size_t i = 0; i < 2; ++i)
+        {
+            readers.push_back(std::thread([&]()
+            {
+                Snapshot::Reader reader(snapshot);
+                Int last = 0;
+                while (!stop)
+                {
+                    const SnapshotParamHolder& param = reader();
+                    if (param().first() != param().second() || param().first() < last)
+                        error = true;
+                    last = param().first();
+                }
+            }));
+        }
+        for (size_t i = 1; i <= updates; ++i)
+        {
+            String text = "snapshot:\n  first: " + Cpl::ToStr(i) + "\n  second: " + Cpl::ToStr(i) + "\n";
+            if (!snapshot.Load(text.c_str(), text.size(), Cpl::ParamFormatYaml))
+                error = true;
+        }
+        stop = true;
+        for (size_t i = 0; i < readers.size(); ++i)
+            readers[i].join();
+        if (error || snapshot.Version() != updates + 1 || snapshot.Current()->operator()().first() != Int(updates))
+        {
+            CPL_LOG_SS(Error, "ParamSnapshot readers see inconsistent snapshot!");
+            return false;
+        }
+        if (changed != Strings({ "first", "second" }))
+        {
+            CPL_LOG_SS(Error, "ParamSnapshot reports wrong changed members!");
+            return false;
+        }
+        if (once.calls != 1)
+        {
+            CPL_LOG_SS(Error, "ParamSnapshot callback can't remove itself!");
+            return false;
+        }
+
+        changed.clear();
+        std::shared_ptr<SnapshotParamHolder> next = std::make_shared<SnapshotParamHolder>();
+        next->Clone(*snapshot.Current());
+        snapshot.Publish(std::move(next));
+        if (changed.size())
+        {
+            CPL_LOG_SS(Error, "ParamSnapshot notifies about equal snapshot!");
+            return false;
+        }
+        next = std::make_shared<SnapshotParamHolder>();
+        next->Clone(*snapshot.Current());
+        (*next)().name() = "Other";
+        if (!next->Save("snapshot_async.yml", true) || !snapshot.LoadAsync("snapshot_async.yml").get())
+        {
+            CPL_LOG_SS(Error, "ParamSnapshot can't load snapshot asynchronously!");
+            return false;
+        }
+        if (changed != Strings({ "name" }) || snapshot.Current()->operator()().name() != "Other")
+        {
+            CPL_LOG_SS(Error, "ParamSnapshot reports wrong changed members!");
+            return false;
+        }
+        return true;
+    }
+}
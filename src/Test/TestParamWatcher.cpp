@@ -0,0 +1,165 @@
+/*
+* Tests for Common Purpose Library (http://github.com/ermig1979/Cpl).
+*
+* Copyright (c) 2021-2024 Yermalayeu Ihar.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include "Test/Test.h"
+
+#include "Cpl/ParamWatcher.h"
+
+namespace Test
+{
+    struct WatcherParam
+    {
+        CPL_PARAM_VALUE(Int, value, 0);
+        CPL_PARAM_VALUE(String, name, "Name");
+    };
+
+    CPL_PARAM_HOLDER(WatcherParamHolder, WatcherParam, watcher);
+
+    typedef Cpl::ParamWatcher<WatcherParamHolder> Watcher;
+
+    struct WatcherState
+    {
+        std::mutex mutex;
+        Int value;
+        size_t calls;
+
+        WatcherState()
+            : value(-1)
+            , calls(0)
+        {
+        }
+    };
+
+    static void WatcherReloaded(const Watcher::Pointer& param, void* userData)
+    {
+        WatcherState* state = (WatcherState*)userData;
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->value = (*param)().value();
+        state->calls++;
+    }
+
+    struct ReentrantState
+    {
+        Watcher* watcher;
+        size_t calls;
+    };
+
+    static void WatcherReentered(const Watcher::Pointer&, void* userData)
+    {
+        ReentrantState* state = (ReentrantState*)userData;
+        state->calls++;
+        state->watcher->Check();
+    }
+
+    static bool WriteWatched(const String& path, Int value)
+    {
+        std::ofstream ofs(path.c_str());
+        ofs << "watcher:\n  value: " << value << "\n";
+        return (bool)ofs;
+    }
+
+    static bool WaitWatched(WatcherState& state, size_t calls, Int value)
+    {
+        for (double stop = Cpl::Time() + 5.0; Cpl::Time() < stop;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (state.calls == calls && state.value == value)
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    }
+
+    static bool ParamWatcherTest(bool polling)
+    {
+        String path = polling ? "watcher_polling.yml" : "watcher_inotify.yml";
+        if (!WriteWatched(path, 1))
+            return false;
+        WatcherState state;
+        Watcher watcher(path, WatcherReloaded, &state);
+        if (!watcher.Start(0.200, 0.020, polling))
+        {
+            CPL_LOG_SS(Error, "ParamWatcher can't start!");
+            return false;
+        }
+        CPL_LOG_SS(Info, "ParamWatcher uses " << (watcher.Inotify() ? "inotify" : "polling") << ".");
+        if (watcher.Reloads() != 1 || !WaitWatched(state, 1, 1))
+        {
+            CPL_LOG_SS(Error, "ParamWatcher doesn't load initial file!");
+            return false;
+        }
+        if (!WriteWatched(path, 2) || !WaitWatched(state, 2, 2))
+        {
+            CPL_LOG_SS(Error, "ParamWatcher doesn't reload changed file!");
+            return false;
+        }
+        if (!WriteWatched(path, 2) || watcher.Check() || watcher.Reloads() != 2)
+        {
+            CPL_LOG_SS(Error, "ParamWatcher reloads file with the same content!");
+            return false;
+        }
+        for (Int i = 3; i <= 5; ++i)
+            WriteWatched(path, i);
+        if (!WaitWatched(state, 3, 5))
+        {
+            CPL_LOG_SS(Error, "ParamWatcher doesn't debounce changes!");
+            return false;
+        }
+        watcher.Stop();
+        return true;
+    }
+
+    static bool ParamWatcherReentrantTest()
+    {
+        String path = "watcher_reentrant.yml";
+        if (!WriteWatched(path, 1))
+            return false;
+        ReentrantState state = { NULL, 0 };
+        Watcher watcher(path, WatcherReentered, &state);
+        state.watcher = &watcher;
+        if (!watcher.Start(0.200, 0.020, true) || state.calls != 1)
+        {
+            CPL_LOG_SS(Error, "ParamWatcher callback can't call Check()!");
+            return false;
+        }
+        watcher.Stop();
+        return true;
+    }
+
+    bool ParamWatcherTest()
+    {
+        bool result = true;
+
+        result = result && ParamWatcherTest(false);
+
+        result = result && ParamWatcherTest(true);
+
+        result = result && ParamWatcherReentrantTest();
+
+        return result;
+    }
+}
@@ -146,6 +146,63 @@ namespace Test
         return true;
 }
 
+    bool PerformanceAllocationTest()
+    {
+#if defined(CPL_PERF_ENABLE) && defined(CPL_PERF_ALLOC_ENABLE)
+        struct alignas(64) Aligned
+        {
+            char data[64];
+        };
+        Cpl::PerformanceMeasurer pm("allocation");
+        for (size_t i = 0; i < 10; ++i)
+        {
+            pm.Enter();
+            std::vector<int> vector(100);
+            std::unique_ptr<double> pointer(new double(1.0));
+            std::unique_ptr<Aligned> aligned(new Aligned());
+            pm.Leave();
+        }
+        if (pm.Allocations() != 3.0 || pm.AllocatedBytes() != double(100 * sizeof(int) + sizeof(double) + sizeof(Aligned)))
+        {
+            CPL_LOG_SS(Error, "Wrong allocation statistics: " << pm.ToStr() << " !");
+            return false;
+        }
+        CPL_LOG_SS(Verbose, pm.Name() << ": " << pm.ToStr());
+#endif
+        return true;
+    }
+
+    static void CountWarnings(Cpl::Log::Level level, const char*, void* userData)
+    {
+        if (level == Cpl::Log::Warning)
+            (*(size_t*)userData)++;
+    }
+
+    bool PerformanceSlowTest()
+    {
+#if defined(CPL_PERF_ENABLE)
+        size_t warnings = 0;
+        int id = Cpl::Log::Global().AddContextWriter(Log::Warning, CountWarnings, &warnings, Cpl::Log::ThreadContext());
+        Cpl::PerformanceMeasurer pm("slow");
+        pm.SetSlow(1.0);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            pm.Enter();
+            std::this_thread::sleep_for(std::chrono::milliseconds(3));
+            pm.Leave();
+        }
+        pm.Enter();
+        pm.Leave();
+        Cpl::Log::Global().RemoveWriter(id);
+        if (warnings != 1)
+        {
+            CPL_LOG_SS(Error, "Wrong number of slow call warnings: " << warnings << " !");
+            return false;
+        }
+#endif
+        return true;
+    }
+
 #if defined(CPL_TEST_NORETURN)
     static void* TestFuncV6(void*)
     {
@@ -25,6 +25,9 @@
 
 #include "Test/Test.h"
 #include "Cpl/String.h"
+#include "Cpl/Yaml.h"
+
+#include <typeinfo>
 
 namespace
 {
@@ -220,7 +223,7 @@ namespace Test
     template <typename T>
     void toStrTestImpl(const T& x) {
         Cpl::String s = Cpl::ToStr(x);
-        std::cout << "  ToStr((" << typeid(T).name() << ")" << x << ")='" << s << "'" << std::endl;
+        CPL_LOG_SS(Info, "  ToStr((" << typeid(T).name() << ")" << x << ")='" << s << "'");
     };
     template<typename T, typename... Ts>
     void toStrTestImpl(const T& x, Ts... ts) {
@@ -256,6 +259,51 @@ namespace Test
         return true;
     }
 
+    template<class T> bool ToValCheck(const Cpl::String& string)
+    {
+        T expected = T(3), value = T(3), type = T(7);
+        std::stringstream ss(string);
+        ss >> expected;
+        bool failed = ss.fail();
+        Cpl::ToVal(string, value);
+        if (value != expected || (!failed && Cpl::ToVal<T>(string) != expected) || Cpl::Yaml::Node(string).As<T>(type) != (failed ? type : expected))
+        {
+            CPL_LOG_SS(Error, "ToVal<" << typeid(T).name() << ">('" << string << "') returns " << value << " instead of " << expected << " !");
+            return false;
+        }
+        return true;
+    }
+
+    bool ToValTest()
+    {
+        const char* strings[] = { "0", "123456", "-42", "+17", "  8", "\t-9 ", "12abc", "abc", "", "-", "1.5", "-0.125", ".5", "5.",
+            "1e3", "1e", "2.5E-3", "0x1A", "inf", "-nan", "99999999999", "-99999999999", "18446744073709551616", "1e400", "1.5.3" };
+        bool result = true;
+        for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); ++i)
+        {
+            result = result && ToValCheck<int>(strings[i]);
+            result = result && ToValCheck<unsigned int>(strings[i]);
+            result = result && ToValCheck<short>(strings[i]);
+            result = result && ToValCheck<int64_t>(strings[i]);
+            result = result && ToValCheck<unsigned short>(strings[i]);
+            result = result && ToValCheck<float>(strings[i]);
+            result = result && ToValCheck<double>(strings[i]);
+        }
+        const char* trues[] = { "1", "true", "True", "YES", "on" }, * falses[] = { "0", "false", "FALSE", "no", "Off" };
+        for (size_t i = 0; i < 5; ++i)
+        {
+            bool t = false, f = true;
+            Cpl::ToVal(trues[i], t);
+            Cpl::ToVal(falses[i], f);
+            if (!t || f)
+            {
+                CPL_LOG_SS(Error, "ToVal<bool>('" << trues[i] << "'/'" << falses[i] << "') returns wrong value!");
+                return false;
+            }
+        }
+        return result;
+    }
+
     bool CurrentDateTimeStringTest()
     {
         std::vector<std::pair<Cpl::String, size_t>> testCases = 
@@ -23,7 +23,10 @@
 * SOFTWARE.
 */
 
+#include "Test/Test.h"
+
 #include "Cpl/Xml.h"
+#include "Cpl/XmlPath.h"
 #include <iostream>
 #include <string>
 
@@ -147,4 +150,377 @@ namespace Test
 
         return true;
     }
+
+    static String XmlReaderTrace(const String& xml, size_t chunk)
+    {
+        Cpl::Xml::XmlReader<char, Cpl::Xml::ParseValidateClosingTags> reader;
+        Cpl::Xml::XmlEvent<char> event;
+        std::stringstream trace;
+        size_t offset = 0;
+        do
+        {
+            while (reader.Next(event))
+            {
+                switch (event.type)
+                {
+                case Cpl::Xml::EventStartElement: trace << "<" << String(event.name, event.nameSize); break;
+                case Cpl::Xml::EventAttribute: trace << " " << String(event.name, event.nameSize) << "=" << String(event.value, event.valueSize); break;
+                case Cpl::Xml::EventText: trace << "[" << String(event.value, event.valueSize) << "]"; break;
+                case Cpl::Xml::EventEndElement: trace << "</" << String(event.name, event.nameSize) << ">"; break;
+                default: break;
+                }
+            }
+            if (event.type == Cpl::Xml::EventNeedMore)
+            {
+                if (offset < xml.size())
+                {
+                    size_t size = std::min(chunk, xml.size() - offset);
+                    reader.Feed(xml.c_str() + offset, size);
+                    offset += size;
+                }
+                else
+                    reader.Finish();
+            }
+        } while (event.type != Cpl::Xml::EventEnd);
+        return trace.str();
+    }
+
+    bool XmlReaderTest()
+    {
+        const String xml =
+            "<?xml version=\"1.0\"?>\n"
+            "<!-- comment with <tags> -->\n"
+            "<root id=\"1\" name='a &amp; b'>\n"
+            "\t<item value=\"x > y\"/>\n"
+            "\t<text>one &lt;two&gt; &#65;</text>\n"
+            "\t<data><![CDATA[<raw>]]></data>\n"
+            "</root>\n";
+        const String expected =
+            "<root id=1 name=a & b"
+            "<item value=x > y</item>"
+            "<text[one <two> A]</text>"
+            "<data[<raw>]</data>"
+            "</root>";
+        for (size_t chunk = 1; chunk <= xml.size(); ++chunk)
+        {
+            String trace = XmlReaderTrace(xml, chunk);
+            if (trace != expected)
+            {
+                CPL_LOG_SS(Error, "XmlReader with chunk " << chunk << " returns '" << trace << "' instead of '" << expected << "' !");
+                return false;
+            }
+        }
+
+        try
+        {
+            XmlReaderTrace("<a><b></a>", 3);
+            CPL_LOG_SS(Error, "XmlReader does not detect invalid closing tag!");
+            return false;
+        }
+        catch (const Cpl::Xml::ParseError& error)
+        {
+            CPL_LOG_SS(Verbose, "XmlReader error: " << error.What());
+        }
+        return true;
+    }
+
+    bool XmlPrintTest()
+    {
+        String xml =
+            "<root id=\"1\" name='a &amp; b' quote='say \"hi\"'>"
+            "<item value=\"x &gt; y\"/>"
+            "<text>one &lt;two&gt; &amp; 'three'</text>"
+            "<data><![CDATA[<raw>]]></data>"
+            "<list><a>1</a><b>2</b></list>"
+            "</root>";
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.Parse<0>((char*)xml.c_str(), xml.size());
+
+        String expected;
+        Cpl::Xml::Print(std::back_inserter(expected), doc);
+        for (size_t capacity = 1; capacity <= expected.size() + 1; capacity += 7)
+        {
+            String printed;
+            {
+                Cpl::OutputBuffer<char> buffer(Cpl::FlushToString<char>, &printed, capacity);
+                Cpl::Xml::Print(Cpl::Xml::OutputIterator<char>(&buffer), doc);
+            }
+            if (printed != expected)
+            {
+                CPL_LOG_SS(Error, "Buffered Xml::Print with capacity " << capacity << " returns '" << printed << "' instead of '" << expected << "' !");
+                return false;
+            }
+        }
+
+        std::stringstream ss;
+        ss << doc;
+        String printed;
+        Cpl::Xml::PrintToString(printed, doc);
+        if (ss.str() != expected || printed != expected)
+        {
+            CPL_LOG_SS(Error, "Xml::Print to stream or string returns wrong output!");
+            return false;
+        }
+
+        if (!Cpl::Xml::PrintToFile("xml_print.xml", doc))
+        {
+            CPL_LOG_SS(Error, "Can't print XML to file 'xml_print.xml' !");
+            return false;
+        }
+        Cpl::Xml::File<char> file("xml_print.xml");
+        if (String(file.Data(), file.Size() - 1) != expected)
+        {
+            CPL_LOG_SS(Error, "Xml::PrintToFile returns wrong output!");
+            return false;
+        }
+        return true;
+    }
+
+    static String XmlParseParallelPrint(String xml, size_t threads)
+    {
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.ParseParallel<0>((char*)xml.c_str(), xml.size(), threads);
+        String printed;
+        Cpl::Xml::PrintToString(printed, doc);
+        return printed;
+    }
+
+    bool XmlParseParallelTest()
+    {
+        std::stringstream ss;
+        ss << "<?xml version=\"1.0\"?>\n<!-- items -->\n<root version=\"1\">\n";
+        for (size_t i = 0; i < 20000; ++i)
+        {
+            ss << "\t<item id=\"" << i << "\" name='a &amp; b > c'>";
+            ss << "<value>" << i * 3 << "</value><!-- </item> --><data><![CDATA[<" << i << ">]]></data>";
+            ss << "<empty/></item>\n";
+        }
+        ss << "</root>\n";
+        const String xml = ss.str();
+
+        String expected;
+        {
+            String copy = xml;
+            Cpl::Xml::XmlDocument<char> doc;
+            doc.Parse<0>((char*)copy.c_str(), copy.size());
+            Cpl::Xml::PrintToString(expected, doc);
+        }
+        for (size_t threads = 1; threads <= 4; ++threads)
+        {
+            if (XmlParseParallelPrint(xml, threads) != expected)
+            {
+                CPL_LOG_SS(Error, "XmlDocument::ParseParallel with " << threads << " threads returns wrong document!");
+                return false;
+            }
+        }
+
+        String mixed = "<root>text<a>1</a>" + String(Cpl::Xml::PARALLEL_PART_SIZE * 2, ' ') + "<b>2</b></root>";
+        if (XmlParseParallelPrint(mixed, 4) != XmlParseParallelPrint(mixed, 1))
+        {
+            CPL_LOG_SS(Error, "XmlDocument::ParseParallel returns wrong document with mixed content!");
+            return false;
+        }
+
+        try
+        {
+            String broken = xml;
+            broken.replace(broken.rfind("<empty/>"), 8, "<empty>");
+            XmlParseParallelPrint(broken, 4);
+            CPL_LOG_SS(Error, "XmlDocument::ParseParallel does not detect error!");
+            return false;
+        }
+        catch (const Cpl::Xml::ParseError& error)
+        {
+            CPL_LOG_SS(Verbose, "XmlDocument::ParseParallel error: " << error.What());
+        }
+
+        try
+        {
+            String broken = xml;
+            size_t pos = broken.find("<value>", broken.size() / 4);
+            broken.replace(pos, 7, "<value =>");
+            XmlParseParallelPrint(broken, 4);
+            CPL_LOG_SS(Error, "XmlDocument::ParseParallel does not detect error in chunk!");
+            return false;
+        }
+        catch (const Cpl::Xml::ParseError& error)
+        {
+            CPL_LOG_SS(Verbose, "XmlDocument::ParseParallel chunk error: " << error.What());
+        }
+        return true;
+    }
+
+    static bool XmlPathCheck(const Cpl::Xml::XmlNode<char>* context, const char* path, size_t count, const String& value)
+    {
+        Cpl::Xml::XmlPath<char> compiled(path);
+        String first;
+        size_t selected = 0;
+        if (compiled.Attribute())
+        {
+            Cpl::Xml::XmlPath<char>::Attributes attributes;
+            selected = compiled.SelectAttributes(context, attributes);
+            if (Cpl::Xml::XmlAttribute<char>* attribute = compiled.FirstAttribute(context))
+                first = String(attribute->Value(), attribute->ValueSize());
+        }
+        else
+        {
+            Cpl::Xml::XmlPath<char>::Nodes nodes;
+            selected = compiled.Select(context, nodes);
+            if (Cpl::Xml::XmlNode<char>* node = compiled.First(context))
+                first = String(node->Value(), node->ValueSize());
+            if (selected && nodes[0] != compiled.First(context))
+                selected = size_t(-1);
+        }
+        if (selected != count || first != value)
+        {
+            CPL_LOG_SS(Error, "XmlPath '" << path << "' selects " << selected << " items ('" << first << "') instead of " << count << " ('" << value << "') !");
+            return false;
+        }
+        return true;
+    }
+
+    bool XmlPathTest()
+    {
+        String xml =
+            "<root>"
+            "<items>"
+            "<item id=\"1\" kind=\"a\"><name>one</name></item>"
+            "<item id=\"2\" kind=\"b\"><name>two</name></item>"
+            "<item id=\"3\" kind=\"a\"><name>three</name><item id=\"4\"><name>four</name></item></item>"
+            "</items>"
+            "<other><name>x</name></other>"
+            "</root>";
+        for (int intern = 0; intern < 2; ++intern)
+        {
+            String copy = xml;
+            Cpl::Xml::XmlDocument<char> doc;
+            if (intern)
+                doc.Parse<Cpl::Xml::ParseInternNames>((char*)copy.c_str(), copy.size());
+            else
+                doc.Parse<0>((char*)copy.c_str(), copy.size());
+            Cpl::Xml::XmlNode<char>* items = doc.FirstNode()->FirstNode("items");
+            items->AppendNode(doc.AllocateNode(Cpl::Xml::NodeElement, "extra", "added"));
+
+            bool result = true;
+            result = result && XmlPathCheck(&doc, "/root/items/item", 3, "");
+            result = result && XmlPathCheck(&doc, "//item", 4, "");
+            result = result && XmlPathCheck(&doc, "/root/items/item[2]/name", 1, "two");
+            result = result && XmlPathCheck(&doc, "//item[@kind='a']/name", 2, "one");
+            result = result && XmlPathCheck(&doc, "//item[@kind]", 3, "");
+            result = result && XmlPathCheck(&doc, "/root/*/name", 1, "x");
+            result = result && XmlPathCheck(&doc, "//name", 5, "one");
+            result = result && XmlPathCheck(&doc, "//item//name", 4, "one");
+            result = result && XmlPathCheck(&doc, "/root/items/item/@id", 3, "1");
+            result = result && XmlPathCheck(&doc, "//item[@id=\"4\"]/@id", 1, "4");
+            result = result && XmlPathCheck(&doc, "//missing", 0, "");
+            result = result && XmlPathCheck(items, "item[3]/item/name", 1, "four");
+            result = result && XmlPathCheck(items, "/root/other/name", 1, "x");
+            result = result && XmlPathCheck(items, "item[4]", 0, "");
+            result = result && XmlPathCheck(items, "extra", 1, "added");
+            if (!result)
+                return false;
+        }
+
+        {
+            String nested = "<r><a id=\"1\"><a id=\"2\"/></a><a id=\"3\"/></r>";
+            Cpl::Xml::XmlDocument<char> doc;
+            doc.Parse<0>((char*)nested.c_str(), nested.size());
+            Cpl::Xml::XmlPath<char>::Nodes nodes;
+            Cpl::Xml::XmlPath<char>("//a").Select(&doc, nodes);
+            String order;
+            for (size_t i = 0; i < nodes.size(); ++i)
+                order += String(i ? " " : "") + nodes[i]->FirstAttribute("id")->Value();
+            if (order != "1 2 3")
+            {
+                CPL_LOG_SS(Error, "XmlPath '//a' selects nodes in order '" << order << "' instead of document order '1 2 3' !");
+                return false;
+            }
+        }
+
+        const char* invalids[] = { "", "/root/[1]", "//item[0]", "//item[@id='1]", "/root/@id/name", "root//",
+            "/r/a[@k][@j]", "/r/a[1][2]", "/r/a[2][@k]" };
+        for (size_t i = 0; i < sizeof(invalids) / sizeof(invalids[0]); ++i)
+        {
+            try
+            {
+                Cpl::Xml::XmlPath<char> path(invalids[i]);
+                CPL_LOG_SS(Error, "XmlPath '" << invalids[i] << "' is compiled without error!");
+                return false;
+            }
+            catch (const Cpl::Xml::ParseError& error)
+            {
+                CPL_LOG_SS(Verbose, "XmlPath '" << invalids[i] << "' error: " << error.What());
+            }
+        }
+        return true;
+    }
+
+    static bool XmlInternNamesCheck(const Cpl::Xml::XmlDocument<char>& doc, const Cpl::Xml::XmlNode<char>* node)
+    {
+        if (node->NameId() != (node->Type() == Cpl::Xml::NodeElement ? doc.NameId(node->Name(), node->NameSize()) : 0))
+            return false;
+        for (const Cpl::Xml::XmlAttribute<char>* attribute = node->FirstAttribute(); attribute; attribute = attribute->NextAttribute())
+            if (attribute->NameId() == 0 || attribute->NameId() != doc.NameId(attribute->Name(), attribute->NameSize()))
+                return false;
+        for (const Cpl::Xml::XmlNode<char>* child = node->FirstNode(); child; child = child->NextSibling())
+            if (!XmlInternNamesCheck(doc, child))
+                return false;
+        return true;
+    }
+
+    bool XmlInternNamesTest()
+    {
+        String xml =
+            "<root>"
+            "<item id=\"1\" kind=\"a\"><name>one</name></item>"
+            "text"
+            "<other id=\"x\"/>"
+            "<item kind=\"b\" id=\"2\"><name>two</name></item>"
+            "</root>";
+        Cpl::Xml::XmlDocument<char> doc;
+        doc.Parse<Cpl::Xml::ParseInternNames>((char*)xml.c_str(), xml.size());
+        if (doc.NameCount() != 6 || !XmlInternNamesCheck(doc, &doc))
+        {
+            CPL_LOG_SS(Error, "XmlDocument::Parse returns wrong name ids!");
+            return false;
+        }
+
+        size_t item = doc.NameId("item"), id = doc.NameId("id"), name = doc.NameId("name", 4);
+        const Cpl::Xml::XmlNode<char>* root = doc.FirstNode();
+        const Cpl::Xml::XmlNode<char>* first = root->FirstNodeById(item);
+        const Cpl::Xml::XmlNode<char>* second = first ? first->NextSiblingById(item) : 0;
+        if (first != root->FirstNode("item") || second != first->NextSibling("item") || second->NextSiblingById(item) ||
+            second->FirstNodeById(name) != second->FirstNode("name") || second->FirstAttributeById(id) != second->FirstAttribute("id") ||
+            first->FirstAttributeById(id)->NextAttributeById(id) || second->FirstAttributeById(doc.NameId("kind"))->NextAttributeById(id) != second->LastAttribute() ||
+            doc.NameId("missing") != 0 || root->FirstNodeById(0) != 0)
+        {
+            CPL_LOG_SS(Error, "XmlNode lookup by name id returns wrong result!");
+            return false;
+        }
+
+        std::stringstream ss;
+        ss << "<root>\n";
+        for (size_t i = 0; i < 20000; ++i)
+            ss << "\t<item" << i % 7 << " id=\"" << i << "\" a" << i % 5 << "=\"\"><value" << i % 3 << ">" << i << "</value" << i % 3 << "></item" << i % 7 << ">\n";
+        ss << "</root>\n";
+        String large = ss.str();
+        for (size_t threads = 1; threads <= 4; ++threads)
+        {
+            String copy = large;
+            doc.ParseParallel<Cpl::Xml::ParseInternNames>((char*)copy.c_str(), copy.size(), threads);
+            if (doc.NameCount() != 1 + 7 + 1 + 5 + 3 || !XmlInternNamesCheck(doc, &doc))
+            {
+                CPL_LOG_SS(Error, "XmlDocument::ParseParallel with " << threads << " threads returns wrong name ids!");
+                return false;
+            }
+        }
+
+        doc.Clear();
+        if (doc.NameCount() || doc.NameId("root"))
+        {
+            CPL_LOG_SS(Error, "XmlDocument::Clear does not reset name ids!");
+            return false;
+        }
+        return true;
+    }
 }
\ No newline at end of file
@@ -49,17 +49,263 @@ namespace Test
         }
         catch (const Cpl::Yaml::Exception e)
         {
-            std::cout << "Exception " << e.GetType() << ": " << e.what() << std::endl;
+            CPL_LOG_SS(Error, "Exception " << e.GetType() << ": " << e.what());
             return false;
         }
 
-        std::cout << root["data1"].As<int>(0) << std::endl;
-        std::cout << root["data2"].As<std::string>() << std::endl;
-        std::cout << root["data3"][0]["key1"].As<int>(0) << std::endl;
-        std::cout << root["data3"][0]["key2"].As<std::string>() << std::endl;
-        std::cout << root["data3"][1].As<std::string>() << std::endl;
-        std::cout << root["data3"][2].As<int>(0) << std::endl;
-        std::cout << root["data3"][3].As<float>(0.0f) << std::endl;
+        CPL_LOG_SS(Info, root["data1"].As<int>(0));
+        CPL_LOG_SS(Info, root["data2"].As<std::string>());
+        CPL_LOG_SS(Info, root["data3"][0]["key1"].As<int>(0));
+        CPL_LOG_SS(Info, root["data3"][0]["key2"].As<std::string>());
+        CPL_LOG_SS(Info, root["data3"][1].As<std::string>());
+        CPL_LOG_SS(Info, root["data3"][2].As<int>(0));
+        CPL_LOG_SS(Info, root["data3"][3].As<float>(0.0f));
+
+        const char buffer[] = "---\nfirst: 1\nsecond: 2\n---\nthird: 3\ntrailing";
+        try
+        {
+            Cpl::Yaml::Parse(root, buffer, sizeof(buffer) - 9);
+        }
+        catch (const Cpl::Yaml::Exception& e)
+        {
+            CPL_LOG_SS(Error, "Exception " << e.GetType() << ": " << e.what());
+            return false;
+        }
+        if (root.Size() != 2 || root["first"].As<int>(0) != 1 || root["second"].As<int>(0) != 2)
+        {
+            CPL_LOG_SS(Error, "Parse from buffer must stop at the next document!");
+            return false;
+        }
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    bool YamlSerializeTest()
+    {
+        Cpl::Yaml::Node root;
+        root["plain"] = "value";
+        root["cited:key"] = "a \"quoted\" value";
+        root["esc\"ape\\d"] = "x";
+        root["empty"] = "";
+        root["literal"] = "line one\nline two\n";
+        root["long"] = "The quick brown fox jumps over the lazy dog, then the dog wakes up and chases the fox around the yard.";
+        root["seq"].PushBack() = "first";
+        root["seq"].PushBack()["k"] = "v";
+        root["seq"][1]["m"] = "w";
+        root["map"]["inner"] = "1";
+
+        const std::string expected =
+            "plain: value\n"
+            "\"cited:key\": \"a \"quoted\" value\"\n"
+            "\"esc\\\"ape\\\\d\": x\n"
+            "empty: \n"
+            "literal: |\n"
+            "  line one\n"
+            "  line two\n"
+            "long: >-\n"
+            "  The quick brown fox jumps over the lazy dog, then the dog wakes up\n"
+            "  and chases the fox around the yard.\n"
+            "seq: \n"
+            "  - first\n"
+            "  - k: v\n"
+            "    m: w\n"
+            "map: \n"
+            "  inner: 1\n";
+
+        std::string string = "garbage";
+        Cpl::Yaml::Serialize(root, string);
+        if (string != expected)
+        {
+            CPL_LOG_SS(Error, "Yaml::Serialize returns:\n" << string << "instead of:\n" << expected);
+            return false;
+        }
+
+        root["large"] = std::string(200000, 'z');
+        std::stringstream stream;
+        Cpl::Yaml::Serialize(root, stream);
+        Cpl::Yaml::Serialize(root, string);
+        size_t size = Cpl::Yaml::Serialize(root, "yaml_serialize.yml");
+        std::ifstream ifs("yaml_serialize.yml", std::ios::binary);
+        std::string file((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        if (stream.str() != string || size != string.size() || file != string)
+        {
+            CPL_LOG_SS(Error, "Yaml::Serialize returns different output for stream, string and file!");
+            return false;
+        }
+
+        try
+        {
+            Cpl::Yaml::Serialize(root, string, { 1, 64, false, false });
+            CPL_LOG_SS(Error, "Yaml::Serialize accepts wrong indentation!");
+            return false;
+        }
+        catch (const Cpl::Yaml::OperationException&)
+        {
+        }
+        if (string != stream.str())
+        {
+            CPL_LOG_SS(Error, "Failed Yaml::Serialize changes the output string!");
+            return false;
+        }
+#ifdef __linux__
+        try
+        {
+            Cpl::Yaml::Serialize(root, "/dev/full");
+            CPL_LOG_SS(Error, "Yaml::Serialize doesn't report failed file write!");
+            return false;
+        }
+        catch (const Cpl::Yaml::OperationException&)
+        {
+        }
+#endif
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    bool YamlNodeTest()
+    {
+        Cpl::Yaml::Node seq;
+        for (size_t i = 0; i < 5; ++i)
+            seq.PushBack() = Cpl::ToStr(i);
+        seq.PushFront() = "front";
+        seq.Insert(3) = "middle";
+        seq.Insert(100) = "back";
+        seq.Erase(1);
+        const char* items[] = { "front", "1", "middle", "2", "3", "4", "back" };
+        if (seq.Size() != 7)
+        {
+            CPL_LOG_SS(Error, "Yaml::Node sequence has size " << seq.Size() << " instead of 7!");
+            return false;
+        }
+        size_t index = 0;
+        for (Cpl::Yaml::Iterator it = seq.Begin(); it != seq.End(); it++, index++)
+        {
+            if ((*it).second.As<std::string>() != items[index] || seq[index].As<std::string>() != items[index])
+            {
+                CPL_LOG_SS(Error, "Yaml::Node sequence has wrong item " << index << " !");
+                return false;
+            }
+        }
+        if (!seq[7].IsNone())
+        {
+            CPL_LOG_SS(Error, "Yaml::Node sequence returns item out of range!");
+            return false;
+        }
+
+        Cpl::Yaml::Node map;
+        const size_t size = 1000;
+        for (size_t i = 0; i < size; ++i)
+            map["key" + Cpl::ToStr(size - i)] = Cpl::ToStr(i);
+        for (size_t i = 0; i < size; i += 2)
+            map.Erase("key" + Cpl::ToStr(size - i));
+        if (map.Size() != size / 2)
+        {
+            CPL_LOG_SS(Error, "Yaml::Node map has size " << map.Size() << " instead of " << size / 2 << " !");
+            return false;
+        }
+        index = 1;
+        const Cpl::Yaml::Node& cmap = map;
+        for (Cpl::Yaml::ConstIterator it = cmap.Begin(); it != cmap.End(); it++, index += 2)
+        {
+            const std::string key = "key" + Cpl::ToStr(size - index);
+            if ((*it).first != key || (*it).second.As<size_t>() != index || map[key].As<size_t>() != index)
+            {
+                CPL_LOG_SS(Error, "Yaml::Node map has wrong item " << key << " !");
+                return false;
+            }
+        }
+        if (map.Size() != size / 2)
+        {
+            CPL_LOG_SS(Error, "Yaml::Node map lookup inserts an existing key!");
+            return false;
+        }
+        return true;
+    }
+
+    //---------------------------------------------------------------------------------------------
+
+    bool YamlDocumentReaderTest()
+    {
+        const std::string data =
+            "a: 1\n"
+            "---\n"
+            "b: 2 # comment\n"
+            "...\n"
+            "---\r\n"
+            "- x\n"
+            "- y\n"
+            "---\n"
+            "---\n"
+            "c: 3";
+        std::stringstream stream(data);
+        Cpl::Yaml::DocumentReader reader(stream);
+        Cpl::Yaml::Node node;
+        bool result = reader.Next(node) && node["a"].As<int>() == 1;
+        result = result && reader.Next(node) && node["b"].As<int>() == 2;
+        result = result && reader.Next(node) && node.IsSequence() && node.Size() == 2 && node[1].As<std::string>() == "y";
+        result = result && reader.Next(node) && node.IsNone();
+        result = result && reader.Next(node) && node["c"].As<int>() == 3;
+        result = result && !reader.Next(node) && reader.Count() == 5;
+        if (!result)
+        {
+            CPL_LOG_SS(Error, "Yaml::DocumentReader reads wrong documents from stream!");
+            return false;
+        }
+
+        std::stringstream inlineStream(
+            "--- first\n"
+            "--- |\n"
+            "  literal\n"
+            "--- # comment\n"
+            "key: v\n"
+            "---\n");
+        Cpl::Yaml::DocumentReader inlineReader(inlineStream);
+        result = inlineReader.Next(node) && node.As<std::string>() == "first";
+        result = result && inlineReader.Next(node) && node.As<std::string>() == "literal\n";
+        result = result && inlineReader.Next(node) && node["key"].As<std::string>() == "v";
+        result = result && !inlineReader.Next(node) && inlineReader.Count() == 3;
+        if (!result)
+        {
+            CPL_LOG_SS(Error, "Yaml::DocumentReader reads wrong documents with values on \"---\" lines!");
+            return false;
+        }
+
+        const size_t count = 1000;
+        {
+            std::ofstream ofs("yaml_documents.yml", std::ios::binary);
+            for (size_t i = 0; i < count; ++i)
+                ofs << "---\nid: " << i << "\nvalues:\n  - " << i * 2 << "\n  - " << i * 3 << "\n";
+        }
+        Cpl::Yaml::DocumentReader file("yaml_documents.yml");
+        for (size_t i = 0; file.Next(node); ++i)
+        {
+            if (node["id"].As<size_t>() != i || node["values"][1].As<size_t>() != i * 3)
+            {
+                CPL_LOG_SS(Error, "Yaml::DocumentReader reads wrong document " << i << " from file!");
+                return false;
+            }
+        }
+        if (file.Count() != count)
+        {
+            CPL_LOG_SS(Error, "Yaml::DocumentReader reads " << file.Count() << " documents instead of " << count << " !");
+            return false;
+        }
+
+        std::stringstream broken("a: 1\n---\nb: 2\n\tc: 3\n");
+        Cpl::Yaml::DocumentReader errors(broken);
+        try
+        {
+            errors.Next(node);
+            errors.Next(node);
+            CPL_LOG_SS(Error, "Yaml::DocumentReader doesn't throw exception for broken document!");
+            return false;
+        }
+        catch (const Cpl::Yaml::Exception& e)
+        {
+            CPL_LOG_SS(Info, "Expected exception: " << e.what());
+        }
         return true;
     }
 